@@ -0,0 +1,84 @@
+#include <cstring>
+#include <string_view>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+
+#include <taskio/io/file.hpp>
+#include <taskio/io/socket.hpp>
+#include <taskio/io_context.hpp>
+#include <taskio/log/log.hpp>
+#include <taskio/task.hpp>
+
+using taskio::io_context;
+using taskio::log::log;
+
+namespace io = taskio::io;
+
+constexpr int client_num = 4;
+
+taskio::task<> echo(int fd) {
+    {
+        auto stream = io::recv_multishot(fd);
+        while (true) {
+            io::recv_result r = co_await stream.next();
+            if (r.result <= 0) {
+                break;
+            }
+            // the buffer goes back to the pool when `r` is destroyed
+            co_await io::send(fd, r.buf.data());
+        }
+    }
+    co_await io::close(fd);
+}
+
+taskio::task<> server(int listen_fd) {
+    auto acceptor = io::accept_multishot(listen_fd);
+    for (int i = 0; i < client_num; ++i) {
+        int fd = co_await acceptor.next();
+        if (fd < 0) {
+            log("accept failed: {}\n", fd);
+            break;
+        }
+        co_await echo(fd);
+    }
+}
+
+taskio::task<> client(sockaddr_in addr, int id) {
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    int res = co_await io::connect(
+        fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)
+    );
+    if (res < 0) {
+        log("connect failed: {}\n", res);
+        co_return;
+    }
+
+    std::string_view msg = "ping";
+    co_await io::send(fd, msg);
+    char buf[16]{};
+    int n = co_await io::recv(fd, buf);
+    log("client {} got {}\n", id, std::string_view{buf, buf + n});
+    co_await io::close(fd);
+}
+
+int main() {
+    int listen_fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = 0;
+    socklen_t len = sizeof(addr);
+    ::bind(listen_fd, reinterpret_cast<sockaddr *>(&addr), len);
+    ::listen(listen_fd, SOMAXCONN);
+    ::getsockname(listen_fd, reinterpret_cast<sockaddr *>(&addr), &len);
+
+    io_context ctx;
+    ctx.spawn(server(listen_fd));
+    for (int i = 0; i < client_num; ++i) {
+        ctx.spawn(client(addr, i));
+    }
+    ctx.start();
+    ctx.join();
+    ::close(listen_fd);
+}
@@ -0,0 +1,53 @@
+#include <cstdio>
+#include <cstring>
+#include <string_view>
+
+#include <taskio/io/file.hpp>
+#include <taskio/io_context.hpp>
+#include <taskio/log/log.hpp>
+#include <taskio/task.hpp>
+
+using taskio::io_context;
+using taskio::log::log;
+
+namespace io = taskio::io;
+
+taskio::task<> copy_through_file() {
+    constexpr std::string_view path = "/tmp/taskio_file_io.txt";
+    constexpr std::string_view text = "hello io_uring\n";
+
+    int fd = co_await io::openat(
+        AT_FDCWD, path.data(), O_RDWR | O_CREAT | O_TRUNC, 0644
+    );
+    if (fd < 0) {
+        log("openat failed: {}\n", fd);
+        co_return;
+    }
+
+    int written = co_await io::write(fd, text, 0);
+    if (written < 0) {
+        taskio::log::err("write failed: {}\n", std::strerror(-written));
+        co_await io::close(fd);
+        co_return;
+    }
+    co_await io::fsync(fd);
+    log("write {} bytes\n", written);
+
+    char buf[64]{};
+    int read = co_await io::read(fd, buf, 0);
+    if (read < 0) {
+        taskio::log::err("read failed: {}\n", std::strerror(-read));
+    } else {
+        log("read {} bytes: {}\n", read,
+            std::string_view{buf, buf + read});
+    }
+
+    co_await io::close(fd);
+}
+
+int main() {
+    io_context ctx;
+    ctx.spawn(copy_through_file());
+    ctx.start();
+    ctx.join();
+}
@@ -0,0 +1,101 @@
+#include <cstdio>
+#include <span>
+#include <string>
+#include <string_view>
+
+#include <taskio/async_generator.hpp>
+#include <taskio/io/file.hpp>
+#include <taskio/io_context.hpp>
+#include <taskio/log/log.hpp>
+#include <taskio/task.hpp>
+
+using taskio::async_generator;
+using taskio::io_context;
+using taskio::log::log;
+
+namespace io = taskio::io;
+
+constexpr std::string_view path = "/tmp/taskio_file_records.txt";
+
+// read the file chunk by chunk, each chunk is handed over as one batch
+async_generator<char> read_chunks(int fd) {
+    char buf[4096];
+    uint64_t offset = 0;
+    while (true) {
+        int n = co_await io::read(fd, buf, offset);
+        if (n <= 0) {
+            co_return;
+        }
+        offset += n;
+        co_yield std::span<const char>{buf, static_cast<std::size_t>(n)};
+    }
+}
+
+// split the chunks into newline terminated records
+async_generator<std::string_view> read_records(int fd) {
+    auto chunks = read_chunks(fd);
+    std::string partial;
+    while (true) {
+        auto chunk = co_await chunks.next_batch();
+        if (chunk.empty()) {
+            break;
+        }
+
+        std::string_view rest{chunk.data(), chunk.size()};
+        for (auto pos = rest.find('\n'); pos != rest.npos;
+             pos = rest.find('\n')) {
+            if (partial.empty()) {
+                co_yield rest.substr(0, pos);
+            } else {
+                partial.append(rest.substr(0, pos));
+                co_yield std::string_view{partial};
+                partial.clear();
+            }
+            rest.remove_prefix(pos + 1);
+        }
+        partial.append(rest);
+    }
+
+    if (!partial.empty()) {
+        co_yield std::string_view{partial};
+    }
+}
+
+taskio::task<> write_records(int fd, int count) {
+    std::string text;
+    for (int i = 0; i < count; ++i) {
+        text += "record " + std::to_string(i) + "\n";
+    }
+    co_await io::write(fd, text, 0);
+    co_await io::fsync(fd);
+}
+
+taskio::task<> parse_file() {
+    int fd = co_await io::openat(
+        AT_FDCWD, path.data(), O_RDWR | O_CREAT | O_TRUNC, 0644
+    );
+    if (fd < 0) {
+        log("openat failed: {}\n", fd);
+        co_return;
+    }
+
+    co_await write_records(fd, 10000);
+
+    auto records = read_records(fd);
+    int count = 0;
+    std::size_t bytes = 0;
+    while (const std::string_view *record = co_await records.next()) {
+        ++count;
+        bytes += record->size();
+    }
+    log("parsed {} records, {} bytes\n", count, bytes);
+
+    co_await io::close(fd);
+}
+
+int main() {
+    io_context ctx;
+    ctx.spawn(parse_file());
+    ctx.start();
+    ctx.join();
+}
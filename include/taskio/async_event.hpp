@@ -0,0 +1,76 @@
+#pragma once
+
+#include <atomic>
+#include <coroutine>
+
+#include <taskio/detail/async_waiter.hpp>
+
+namespace taskio {
+
+/**
+ * @brief A manual-reset event: awaiting it suspends until it is set, then
+ * every waiter is resumed on its own context and later waits complete at
+ * once until reset().
+ */
+class async_event {
+  public:
+    explicit async_event(bool set = false) noexcept
+        : state(set ? this : nullptr) {}
+
+    // nobody must be waiting
+    ~async_event() = default;
+
+    async_event(const async_event &) = delete;
+    async_event &operator=(const async_event &) = delete;
+
+    struct wait_awaiter {
+        bool await_ready() const noexcept { return event.is_set(); }
+
+        bool await_suspend(std::coroutine_handle<> current) noexcept {
+            waiter.suspend(current);
+            return event.enqueue(&waiter);
+        }
+
+        void await_resume() const noexcept {}
+
+        async_event &event;
+        detail::async_waiter waiter;
+    };
+
+    [[nodiscard]]
+    bool is_set() const noexcept {
+        return state.load(std::memory_order_acquire) == this;
+    }
+
+    /**
+     * @brief `co_await` it to wait until the event is set
+     */
+    [[nodiscard]]
+    wait_awaiter wait() noexcept {
+        return {*this, {}};
+    }
+
+    /**
+     * @brief Set the event and schedule every waiter, thread-safe
+     */
+    void set() noexcept;
+
+    /**
+     * @brief Clear the event if set, thread-safe
+     */
+    void reset() noexcept {
+        const void *expected = this;
+        state.compare_exchange_strong(expected, nullptr,
+                                      std::memory_order_relaxed);
+    }
+
+  private:
+    // returns false if the event got set meanwhile
+    bool enqueue(detail::async_waiter *waiter) noexcept;
+
+    // this when set, otherwise the last waiter pushed, each one pointing to
+    // the one pushed before
+    std::atomic<const void *> state;
+};
+
+} // namespace taskio
@@ -0,0 +1,223 @@
+#pragma once
+
+#include <algorithm>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <span>
+#include <utility>
+
+#include <taskio/detail/frame_pool.hpp>
+#include <taskio/detail/stop_state.hpp>
+
+namespace taskio {
+
+template<typename T>
+class async_generator;
+
+namespace detail {
+    /**
+     * @brief The promise of async_generator. The producer runs only while a
+     * consumer awaits it: `next()` transfers to the producer, a yield or the
+     * end of the producer transfers back.
+     */
+    template<typename T>
+    struct async_generator_promise {
+        struct yield_awaiter {
+            // an empty batch doesn't go back to the consumer
+            bool await_ready() const noexcept { return skip; }
+
+            std::coroutine_handle<> await_suspend(
+                std::coroutine_handle<async_generator_promise> current
+            ) noexcept {
+                return current.promise().consumer;
+            }
+
+            constexpr void await_resume() const noexcept {}
+
+            bool skip = false;
+        };
+
+        static void *operator new(std::size_t size) {
+            return frame_pool::allocate(size);
+        }
+
+        static void operator delete(void *ptr) noexcept {
+            frame_pool::deallocate(ptr);
+        }
+
+        async_generator<T> get_return_object() noexcept;
+
+        std::suspend_always initial_suspend() noexcept { return {}; }
+
+        yield_awaiter final_suspend() noexcept { return {}; }
+
+        // the value stays in the producer's frame until it is resumed
+        yield_awaiter yield_value(const T &val) noexcept {
+            batch = {std::addressof(val), 1};
+            return {};
+        }
+
+        // hand over many values with a single resume
+        yield_awaiter yield_value(std::span<const T> values) noexcept {
+            batch = values;
+            return {values.empty()};
+        }
+
+        void return_void() noexcept {}
+
+        void unhandled_exception() noexcept {
+            exception = std::current_exception();
+        }
+
+        void rethrow_if_exception() {
+            if (exception) {
+                std::rethrow_exception(std::exchange(exception, nullptr));
+            }
+        }
+
+        // the cancellation of the consumer that resumed the producer
+        stop_state *get_stop_state() const noexcept { return stop; }
+
+        std::span<const T> batch;
+        std::size_t consumed = 0;
+        std::coroutine_handle<> consumer;
+        stop_state *stop = nullptr;
+        std::exception_ptr exception;
+    };
+
+    /**
+     * @brief Resumes the producer when the current batch is used up
+     */
+    template<typename T>
+    struct async_generator_awaiter {
+        using promise_type = async_generator_promise<T>;
+
+        bool await_ready() const noexcept {
+            return coro == nullptr || coro.done() ||
+                   coro.promise().consumed < coro.promise().batch.size();
+        }
+
+        template<typename Promise>
+        std::coroutine_handle<>
+        await_suspend(std::coroutine_handle<Promise> current) noexcept {
+            auto &promise = coro.promise();
+            promise.batch = {};
+            promise.consumed = 0;
+            promise.consumer = current;
+            promise.stop = stop_state_of(current);
+            return coro;
+        }
+
+        // empty once the producer has returned
+        std::span<const T> take(std::size_t max) {
+            if (coro == nullptr) {
+                return {};
+            }
+            auto &promise = coro.promise();
+            if (coro.done()) {
+                promise.rethrow_if_exception();
+                return {};
+            }
+            auto rest = promise.batch.subspan(promise.consumed);
+            auto taken = rest.first(std::min(max, rest.size()));
+            promise.consumed += taken.size();
+            return taken;
+        }
+
+        std::coroutine_handle<promise_type> coro;
+    };
+} // namespace detail
+
+/**
+ * @brief A generator whose producer may `co_await` I/O between yields. It is
+ * consumed from a coroutine on an io_context:
+ *
+ *     while (const T *value = co_await gen.next()) { ... }
+ *
+ * A producer may `co_yield` a single value or a `std::span<const T>`, a
+ * span is handed out by `next()` one element at a time without resuming
+ * the producer, or at once by `next_batch()`. The yielded values stay valid
+ * until the producer is resumed again. The producer observes the
+ * cancellation of the coroutine awaiting it. An exception thrown by the
+ * producer is rethrown from `next()`.
+ */
+template<typename T>
+class async_generator {
+  public:
+    using promise_type = detail::async_generator_promise<T>;
+
+    async_generator() = default;
+
+    explicit async_generator(std::coroutine_handle<promise_type> handle
+    ) noexcept
+        : coro(handle) {}
+
+    async_generator(async_generator &&rhs) noexcept
+        : coro(std::exchange(rhs.coro, nullptr)) {}
+
+    async_generator &operator=(async_generator &&rhs) noexcept {
+        if (this != std::addressof(rhs)) {
+            if (coro) {
+                coro.destroy();
+            }
+            coro = std::exchange(rhs.coro, nullptr);
+        }
+        return *this;
+    }
+
+    // must not be destroyed while a `next()` is pending
+    ~async_generator() {
+        if (coro) {
+            coro.destroy();
+        }
+    }
+
+    /**
+     * @brief `co_await` it to get a pointer to the next value, or nullptr
+     * once the producer has returned
+     */
+    [[nodiscard]]
+    auto next() noexcept {
+        struct awaiter : detail::async_generator_awaiter<T> {
+            const T *await_resume() {
+                auto value = this->take(1);
+                return value.empty() ? nullptr : value.data();
+            }
+        };
+
+        return awaiter{{coro}};
+    }
+
+    /**
+     * @brief `co_await` it to get the rest of the current batch, up to
+     * `max` values, an empty span once the producer has returned
+     */
+    [[nodiscard]]
+    auto next_batch(std::size_t max = SIZE_MAX) noexcept {
+        struct awaiter : detail::async_generator_awaiter<T> {
+            std::span<const T> await_resume() { return this->take(max); }
+
+            std::size_t max;
+        };
+
+        return awaiter{{coro}, max};
+    }
+
+  private:
+    std::coroutine_handle<promise_type> coro = nullptr;
+};
+
+namespace detail {
+    template<typename T>
+    inline async_generator<T>
+    async_generator_promise<T>::get_return_object() noexcept {
+        return async_generator<T>{
+            std::coroutine_handle<async_generator_promise>::from_promise(*this)
+        };
+    }
+} // namespace detail
+
+} // namespace taskio
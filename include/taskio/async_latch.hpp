@@ -0,0 +1,49 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+#include <taskio/async_event.hpp>
+
+namespace taskio {
+
+/**
+ * @brief A single-use countdown: the waiters are resumed, each on its own
+ * context, once the counter reaches zero.
+ */
+class async_latch {
+  public:
+    explicit async_latch(std::ptrdiff_t expected) noexcept
+        : count(expected), ready(expected <= 0) {}
+
+    async_latch(const async_latch &) = delete;
+    async_latch &operator=(const async_latch &) = delete;
+
+    /**
+     * @brief Decrement the counter, thread-safe
+     */
+    void count_down(std::ptrdiff_t n = 1) noexcept {
+        if (count.fetch_sub(n, std::memory_order_acq_rel) <= n) {
+            ready.set();
+        }
+    }
+
+    [[nodiscard]]
+    bool try_wait() const noexcept {
+        return ready.is_set();
+    }
+
+    /**
+     * @brief `co_await` it to wait until the counter reaches zero
+     */
+    [[nodiscard]]
+    async_event::wait_awaiter wait() noexcept {
+        return ready.wait();
+    }
+
+  private:
+    std::atomic<std::ptrdiff_t> count;
+    async_event ready;
+};
+
+} // namespace taskio
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <atomic>
+#include <coroutine>
+#include <cstdint>
+#include <mutex>
+#include <utility>
+
+#include <taskio/detail/async_waiter.hpp>
+
+namespace taskio {
+
+class async_mutex;
+
+/**
+ * @brief Owns a locked async_mutex, unlocks it when destroyed
+ */
+class async_mutex_lock {
+  public:
+    async_mutex_lock(async_mutex &mutex, std::adopt_lock_t) noexcept
+        : mutex(&mutex) {}
+
+    async_mutex_lock(async_mutex_lock &&other) noexcept
+        : mutex(std::exchange(other.mutex, nullptr)) {}
+
+    async_mutex_lock(const async_mutex_lock &) = delete;
+    async_mutex_lock &operator=(const async_mutex_lock &) = delete;
+    async_mutex_lock &operator=(async_mutex_lock &&) = delete;
+
+    inline ~async_mutex_lock();
+
+  private:
+    async_mutex *mutex;
+};
+
+/**
+ * @brief A mutex that suspends the awaiting coroutine instead of blocking
+ * its context. Waiters are served in FIFO order, each one on its own context,
+ * and the mutex may be locked and unlocked from different contexts.
+ */
+class async_mutex {
+  public:
+    async_mutex() noexcept = default;
+
+    // must be unlocked
+    ~async_mutex() = default;
+
+    async_mutex(const async_mutex &) = delete;
+    async_mutex &operator=(const async_mutex &) = delete;
+
+    struct lock_awaiter {
+        bool await_ready() const noexcept { return mutex.try_lock(); }
+
+        bool await_suspend(std::coroutine_handle<> current) noexcept {
+            waiter.suspend(current);
+            return mutex.enqueue(&waiter);
+        }
+
+        void await_resume() const noexcept {}
+
+        async_mutex &mutex;
+        detail::async_waiter waiter;
+    };
+
+    struct scoped_lock_awaiter : lock_awaiter {
+        [[nodiscard]]
+        async_mutex_lock await_resume() const noexcept {
+            return async_mutex_lock{this->mutex, std::adopt_lock};
+        }
+    };
+
+    [[nodiscard]]
+    bool try_lock() noexcept {
+        auto expected = not_locked;
+        return state.compare_exchange_strong(expected, locked_no_waiters,
+                                             std::memory_order_acquire,
+                                             std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief `co_await` it to acquire the mutex
+     */
+    [[nodiscard]]
+    lock_awaiter lock() noexcept {
+        return {*this, {}};
+    }
+
+    /**
+     * @brief `co_await` it to acquire the mutex as an async_mutex_lock
+     */
+    [[nodiscard]]
+    scoped_lock_awaiter scoped_lock() noexcept {
+        return {{*this, {}}};
+    }
+
+    /**
+     * @brief Hand the mutex over to the next waiter, if any, and schedule
+     * it. Any context may unlock.
+     */
+    void unlock() noexcept;
+
+  private:
+    // returns false if the mutex got acquired instead
+    bool enqueue(detail::async_waiter *waiter) noexcept;
+
+    static constexpr std::uintptr_t not_locked = 1;
+    static constexpr std::uintptr_t locked_no_waiters = 0;
+
+    // not_locked, locked_no_waiters or the last waiter pushed, each one
+    // pointing to the one pushed before
+    std::atomic<std::uintptr_t> state{not_locked};
+    // the waiters taken from state in FIFO order, owned by the lock holder
+    detail::async_waiter *waiters = nullptr;
+};
+
+inline async_mutex_lock::~async_mutex_lock() {
+    if (mutex != nullptr) {
+        mutex->unlock();
+    }
+}
+
+} // namespace taskio
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <atomic>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+
+#include <taskio/detail/async_waiter.hpp>
+
+namespace taskio {
+
+/**
+ * @brief A counting semaphore that suspends the awaiting coroutine instead of
+ * blocking its context, to cap the number of tasks in a section, like the
+ * pending reads of a disk. Waiters are served in FIFO order, each one on its
+ * own context.
+ */
+class async_semaphore {
+  public:
+    explicit async_semaphore(std::ptrdiff_t permits) noexcept
+        : count(permits) {}
+
+    // nobody must be waiting
+    ~async_semaphore() = default;
+
+    async_semaphore(const async_semaphore &) = delete;
+    async_semaphore &operator=(const async_semaphore &) = delete;
+
+    struct acquire_awaiter {
+        bool await_ready() const noexcept { return sem.try_acquire(); }
+
+        bool await_suspend(std::coroutine_handle<> current) noexcept {
+            waiter.suspend(current);
+            return sem.enqueue(&waiter);
+        }
+
+        void await_resume() const noexcept {}
+
+        async_semaphore &sem;
+        detail::async_waiter waiter;
+    };
+
+    [[nodiscard]]
+    bool try_acquire() noexcept {
+        auto old = count.load(std::memory_order_relaxed);
+        while (old > 0) {
+            if (count.compare_exchange_weak(old, old - 1,
+                                            std::memory_order_acquire,
+                                            std::memory_order_relaxed)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * @brief `co_await` it to take a permit
+     */
+    [[nodiscard]]
+    acquire_awaiter acquire() noexcept {
+        return {*this, {}};
+    }
+
+    /**
+     * @brief Give back `n` permits, handed over to the waiters first. Any
+     * context may release.
+     */
+    void release(std::ptrdiff_t n = 1) noexcept;
+
+    // the permits left, negative when tasks wait, thread-safe
+    [[nodiscard]]
+    std::ptrdiff_t available() const noexcept {
+        return count.load(std::memory_order_relaxed);
+    }
+
+  private:
+    // returns false if a permit got taken instead
+    bool enqueue(detail::async_waiter *waiter) noexcept;
+
+    // the permits minus the waiters
+    std::atomic<std::ptrdiff_t> count;
+    // the waiters that are owed a permit, the one raising it from 0 wakes
+    // them so that the queue has one consumer at a time
+    std::atomic<std::ptrdiff_t> owed{0};
+    detail::waiter_queue waiters;
+};
+
+} // namespace taskio
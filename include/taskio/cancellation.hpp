@@ -0,0 +1,112 @@
+#pragma once
+
+#include <coroutine>
+#include <utility>
+
+#include <taskio/detail/stop_state.hpp>
+#include <taskio/task.hpp>
+
+namespace taskio {
+
+class cancellation_source;
+
+namespace detail {
+    struct current_token_awaiter;
+}
+
+/**
+ * @brief Observes a cancellation_source, cheap to copy. A default token is
+ * never cancelled.
+ */
+class cancellation_token {
+  public:
+    cancellation_token() noexcept = default;
+
+    [[nodiscard]]
+    bool can_be_cancelled() const noexcept {
+        return state != nullptr;
+    }
+
+    // thread-safe
+    [[nodiscard]]
+    bool is_cancellation_requested() const noexcept {
+        return state != nullptr && state->stop_requested();
+    }
+
+  private:
+    friend class cancellation_source;
+    friend struct detail::current_token_awaiter;
+
+    template<typename T>
+    friend task<T> with_cancellation(task<T> inner, cancellation_token token);
+
+    explicit cancellation_token(detail::stop_state *state) noexcept
+        : state(state) {}
+
+    detail::stop_state *state = nullptr;
+};
+
+/**
+ * @brief Cancels the tasks bound to its tokens, from any thread. The pending
+ * I/O of a cancelled task is aborted through the async-cancel of the ring
+ * that owns it and completes with -ECANCELED, sleeps return -ECANCELED, and
+ * awaiting anything once cancelled completes with -ECANCELED at once. The
+ * source must outlive the tasks bound to it.
+ */
+class cancellation_source {
+  public:
+    cancellation_source() noexcept = default;
+
+    cancellation_source(const cancellation_source &) = delete;
+    cancellation_source &operator=(const cancellation_source &) = delete;
+
+    // thread-safe, the tasks on other contexts are cancelled by their context
+    void request_cancellation() noexcept { state.request_stop(); }
+
+    [[nodiscard]]
+    bool is_cancellation_requested() const noexcept {
+        return state.stop_requested();
+    }
+
+    [[nodiscard]]
+    cancellation_token token() noexcept {
+        return cancellation_token{&state};
+    }
+
+  private:
+    detail::stop_state state;
+};
+
+namespace detail {
+    struct current_token_awaiter : current_stop_state {
+        cancellation_token await_resume() const noexcept {
+            return cancellation_token{this->state};
+        }
+    };
+} // namespace detail
+
+/**
+ * @brief `co_await` it to get the token observed by the current task, for
+ * polling in long computations
+ */
+[[nodiscard]]
+inline detail::current_token_awaiter current_cancellation() noexcept {
+    return {};
+}
+
+/**
+ * @brief Run `inner` until it finishes or `token` is cancelled. `inner` is
+ * also cancelled along with the caller.
+ */
+template<typename T>
+task<T> with_cancellation(task<T> inner, cancellation_token token) {
+    detail::stop_state stop;
+    detail::stop_forwarder from_caller{
+        co_await detail::current_stop_state{}, stop};
+    detail::stop_forwarder from_token{token.state, stop};
+
+    inner.get_handle().promise().set_stop_state(&stop);
+    co_return co_await std::move(inner);
+}
+
+} // namespace taskio
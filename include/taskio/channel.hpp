@@ -0,0 +1,401 @@
+#pragma once
+
+#include <atomic>
+#include <bit>
+#include <cassert>
+#include <concepts>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+#include <taskio/async_semaphore.hpp>
+#include <taskio/config.hpp>
+#include <taskio/detail/async_waiter.hpp>
+#include <taskio/detail/co_spsc.hpp>
+#include <taskio/detail/safety.hpp>
+
+namespace taskio {
+
+enum class channel_kind : bool { spsc, mpmc };
+
+namespace detail {
+
+    template<typename T>
+    concept channel_value = std::default_initializable<T> &&
+                            std::is_nothrow_move_assignable_v<T>;
+
+    /**
+     * @brief One sender and one receiver, each may run on any context. The
+     * values go through a thread-safe spsc ring, a side that finds the ring
+     * full or empty parks itself for the other side to resume it.
+     */
+    template<channel_value T, std::size_t N>
+    class spsc_channel {
+        static_assert(std::has_single_bit(N), "capacity must be 2^n");
+
+      public:
+        spsc_channel() noexcept = default;
+
+        spsc_channel(const spsc_channel &) = delete;
+        spsc_channel &operator=(const spsc_channel &) = delete;
+
+        struct send_awaiter {
+            bool await_ready() const noexcept { return ch.ring.can_push(); }
+
+            bool await_suspend(std::coroutine_handle<> current) noexcept {
+                waiter.suspend(current);
+                return ch.park(ch.sender, &waiter,
+                               [this] { return ch.ring.can_push(); });
+            }
+
+            // there is room, the sender is alone
+            void await_resume() noexcept {
+                [[maybe_unused]] bool pushed =
+                    ch.ring.try_push(std::move(value));
+                assert(pushed);
+                ch.wake(ch.receiver);
+            }
+
+            spsc_channel &ch;
+            T value;
+            async_waiter waiter;
+        };
+
+        struct recv_awaiter {
+            bool await_ready() const noexcept { return ch.ring.can_pop(); }
+
+            bool await_suspend(std::coroutine_handle<> current) noexcept {
+                waiter.suspend(current);
+                return ch.park(ch.receiver, &waiter,
+                               [this] { return ch.ring.can_pop(); });
+            }
+
+            T await_resume() noexcept {
+                T value;
+                [[maybe_unused]] bool popped = ch.ring.try_pop(value);
+                assert(popped);
+                ch.wake(ch.sender);
+                return value;
+            }
+
+            spsc_channel &ch;
+            async_waiter waiter;
+        };
+
+        struct send_n_awaiter {
+            bool await_ready() const noexcept { return ch.ring.can_push(); }
+
+            bool await_suspend(std::coroutine_handle<> current) noexcept {
+                waiter.suspend(current);
+                return ch.park(ch.sender, &waiter,
+                               [this] { return ch.ring.can_push(); });
+            }
+
+            std::size_t await_resume() noexcept {
+                std::size_t sent = 0;
+                while (sent < values.size() &&
+                       ch.ring.try_push(std::move(values[sent]))) {
+                    ++sent;
+                }
+                ch.wake(ch.receiver);
+                return sent;
+            }
+
+            spsc_channel &ch;
+            std::span<T> values;
+            async_waiter waiter;
+        };
+
+        struct recv_n_awaiter {
+            bool await_ready() const noexcept { return ch.ring.can_pop(); }
+
+            bool await_suspend(std::coroutine_handle<> current) noexcept {
+                waiter.suspend(current);
+                return ch.park(ch.receiver, &waiter,
+                               [this] { return ch.ring.can_pop(); });
+            }
+
+            std::size_t await_resume() noexcept {
+                std::size_t received = 0;
+                while (received < out.size() &&
+                       ch.ring.try_pop(out[received])) {
+                    ++received;
+                }
+                ch.wake(ch.sender);
+                return received;
+            }
+
+            spsc_channel &ch;
+            std::span<T> out;
+            async_waiter waiter;
+        };
+
+        [[nodiscard]]
+        send_awaiter send(T value) noexcept {
+            return {*this, std::move(value), {}};
+        }
+
+        [[nodiscard]]
+        recv_awaiter recv() noexcept {
+            return {*this, {}};
+        }
+
+        [[nodiscard]]
+        send_n_awaiter send_n(std::span<T> values) noexcept {
+            return {*this, values, {}};
+        }
+
+        [[nodiscard]]
+        recv_n_awaiter recv_n(std::span<T> out) noexcept {
+            return {*this, out, {}};
+        }
+
+        // false if full, `value` is left untouched then
+        [[nodiscard]]
+        bool try_send(T &value) noexcept {
+            if (!ring.try_push(std::move(value))) {
+                return false;
+            }
+            wake(receiver);
+            return true;
+        }
+
+        // false if empty
+        [[nodiscard]]
+        bool try_recv(T &value) noexcept {
+            if (!ring.try_pop(value)) {
+                return false;
+            }
+            wake(sender);
+            return true;
+        }
+
+      private:
+        // returns false if `ready` turned true and the waiter took itself
+        // back, it goes on without suspending then
+        template<typename Ready>
+        static bool park(std::atomic<async_waiter *> &slot,
+                         async_waiter *waiter, Ready ready) noexcept {
+            slot.store(waiter, std::memory_order_release);
+            // pairs with the fence of wake(), either the peer sees the
+            // waiter or the waiter sees what the peer did
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (!ready()) {
+                return true;
+            }
+            return slot.exchange(nullptr, std::memory_order_acquire) !=
+                   waiter;
+        }
+
+        static void wake(std::atomic<async_waiter *> &slot) noexcept {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (slot.load(std::memory_order_relaxed) != nullptr) [[unlikely]] {
+                async_waiter *waiter =
+                    slot.exchange(nullptr, std::memory_order_acquire);
+                if (waiter != nullptr) {
+                    waiter->resume();
+                }
+            }
+        }
+
+        spsc<uint32_t, static_cast<uint32_t>(N), safety::safe, T> ring;
+        alignas(config::cache_line_size) std::atomic<async_waiter *> sender{
+            nullptr};
+        alignas(config::cache_line_size) std::atomic<async_waiter *> receiver{
+            nullptr};
+    };
+
+    /**
+     * @brief Any number of senders and receivers on any contexts. A
+     * semaphore counts the free cells and another the values, waiting on
+     * them is all the blocking there is, then a cell is claimed in a
+     * sequenced ring.
+     */
+    template<channel_value T, std::size_t N>
+    class mpmc_channel {
+        static_assert(std::has_single_bit(N), "capacity must be 2^n");
+
+      public:
+        mpmc_channel() : cells(new cell[N]) {
+            for (std::size_t i = 0; i < N; ++i) {
+                cells[i].seq.store(i, std::memory_order_relaxed);
+            }
+        }
+
+        mpmc_channel(const mpmc_channel &) = delete;
+        mpmc_channel &operator=(const mpmc_channel &) = delete;
+
+        struct send_awaiter : async_semaphore::acquire_awaiter {
+            void await_resume() noexcept {
+                ch.push(std::move(value));
+                ch.items.release();
+            }
+
+            mpmc_channel &ch;
+            T value;
+        };
+
+        struct recv_awaiter : async_semaphore::acquire_awaiter {
+            T await_resume() noexcept {
+                T value = ch.pop();
+                ch.slots.release();
+                return value;
+            }
+
+            mpmc_channel &ch;
+        };
+
+        // the first cell is waited for, the others are only taken if free
+        struct send_n_awaiter : async_semaphore::acquire_awaiter {
+            std::size_t await_resume() noexcept {
+                std::size_t sent = 1 + ch.take(ch.slots, values.size() - 1);
+                for (std::size_t i = 0; i < sent; ++i) {
+                    ch.push(std::move(values[i]));
+                }
+                ch.items.release(static_cast<std::ptrdiff_t>(sent));
+                return sent;
+            }
+
+            mpmc_channel &ch;
+            std::span<T> values;
+        };
+
+        struct recv_n_awaiter : async_semaphore::acquire_awaiter {
+            std::size_t await_resume() noexcept {
+                std::size_t received = 1 + ch.take(ch.items, out.size() - 1);
+                for (std::size_t i = 0; i < received; ++i) {
+                    out[i] = ch.pop();
+                }
+                ch.slots.release(static_cast<std::ptrdiff_t>(received));
+                return received;
+            }
+
+            mpmc_channel &ch;
+            std::span<T> out;
+        };
+
+        [[nodiscard]]
+        send_awaiter send(T value) noexcept {
+            return {{slots, {}}, *this, std::move(value)};
+        }
+
+        [[nodiscard]]
+        recv_awaiter recv() noexcept {
+            return {{items, {}}, *this};
+        }
+
+        // `values` must not be empty
+        [[nodiscard]]
+        send_n_awaiter send_n(std::span<T> values) noexcept {
+            assert(!values.empty());
+            return {{slots, {}}, *this, values};
+        }
+
+        // `out` must not be empty
+        [[nodiscard]]
+        recv_n_awaiter recv_n(std::span<T> out) noexcept {
+            assert(!out.empty());
+            return {{items, {}}, *this, out};
+        }
+
+        // false if full, `value` is left untouched then
+        [[nodiscard]]
+        bool try_send(T &value) noexcept {
+            if (!slots.try_acquire()) {
+                return false;
+            }
+            push(std::move(value));
+            items.release();
+            return true;
+        }
+
+        // false if empty
+        [[nodiscard]]
+        bool try_recv(T &value) noexcept {
+            if (!items.try_acquire()) {
+                return false;
+            }
+            value = pop();
+            slots.release();
+            return true;
+        }
+
+      private:
+        struct cell {
+            std::atomic<std::size_t> seq;
+            T value;
+        };
+
+        static std::size_t
+        take(async_semaphore &sem, std::size_t max) noexcept {
+            std::size_t taken = 0;
+            while (taken < max && sem.try_acquire()) {
+                ++taken;
+            }
+            return taken;
+        }
+
+        // a cell is free, it may still be read by a receiver of the last
+        // round on another thread
+        void push(T &&value) noexcept {
+            auto pos = tail.fetch_add(1, std::memory_order_relaxed);
+            cell &slot = cells[pos & mask];
+            while (slot.seq.load(std::memory_order_acquire) != pos)
+                [[unlikely]] {
+                std::this_thread::yield();
+            }
+            slot.value = std::move(value);
+            slot.seq.store(pos + 1, std::memory_order_release);
+        }
+
+        // a value is there, it may still be written by its sender
+        T pop() noexcept {
+            auto pos = head.fetch_add(1, std::memory_order_relaxed);
+            cell &slot = cells[pos & mask];
+            while (slot.seq.load(std::memory_order_acquire) != pos + 1)
+                [[unlikely]] {
+                std::this_thread::yield();
+            }
+            T value = std::move(slot.value);
+            slot.seq.store(pos + N, std::memory_order_release);
+            return value;
+        }
+
+        inline static constexpr std::size_t mask = N - 1;
+
+        const std::unique_ptr<cell[]> cells;
+        alignas(config::cache_line_size) std::atomic<std::size_t> tail{0};
+        alignas(config::cache_line_size) std::atomic<std::size_t> head{0};
+        async_semaphore slots{static_cast<std::ptrdiff_t>(N)};
+        async_semaphore items{0};
+    };
+
+} // namespace detail
+
+/**
+ * @brief A bounded channel between tasks on any contexts: `co_await
+ * send(v)` suspends while it is full and `co_await recv()` while it is
+ * empty, the peer that makes room or brings a value resumes the waiter on
+ * the waiter's own context. Nothing is allocated per message and values are
+ * received in the order they were sent.
+ *
+ * send_n moves in as many values as there is room for, waiting for the
+ * first, and returns that count; recv_n fills `out` the same way. Use
+ * channel_kind::mpmc for several senders or receivers.
+ * @tparam N the capacity, 2^n
+ */
+template<
+    typename T,
+    std::size_t N,
+    channel_kind kind = channel_kind::spsc>
+using channel = std::conditional_t<
+    kind == channel_kind::spsc,
+    detail::spsc_channel<T, N>,
+    detail::mpmc_channel<T, N>>;
+
+} // namespace taskio
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 
 namespace taskio {
@@ -18,13 +19,86 @@ namespace config {
     inline constexpr bool is_warning_level = log_level <= level::warning;
     inline constexpr bool is_err_level = log_level <= level::err;
 
+    // the runtime metrics of the contexts, see io_context::metrics()
+    enum class metric_level : uint8_t { none, counters, latency };
+
+    inline constexpr metric_level metrics_level = metric_level::none;
+    // inline constexpr metric_level metrics_level = metric_level::counters;
+    // inline constexpr metric_level metrics_level = metric_level::latency;
+
+    inline constexpr bool is_counter_metrics =
+        metrics_level >= metric_level::counters;
+    // stamps every ready task with the time, two clock reads per task
+    inline constexpr bool is_latency_metrics =
+        metrics_level >= metric_level::latency;
+
+    // Record the task lifecycle and the I/O requests into a ring per thread,
+    // see trace::dump(). No code at all is emitted when off.
+    inline constexpr bool tracing = false;
+    // the latest events kept by each thread, 2^n, 24 bytes each
+    inline constexpr std::size_t trace_ring_size = 65536;
+
+    // Log records are copied in binary into a ring of the logging thread,
+    // then formatted and written in batches by a background thread. warn and
+    // err wait for room, err also waits for its record to be written.
+    inline constexpr bool async_log = false;
+    // the bytes of the ring of each logging thread, 2^n, log and debug
+    // records that don't fit are dropped and counted, warn and err records
+    // larger than half of it are written directly
+    inline constexpr std::size_t log_ring_size = 65536;
+    // how long the background thread sleeps once every ring is empty
+    inline constexpr uint32_t log_idle_us = 500;
+
     using cur_t = uint16_t;
     inline constexpr cur_t spsc_capacity = 16384;
 
+    // the ready queue of an io_context grows by segments of that many tasks
+    inline constexpr uint32_t ready_segment_size = 256;
+    // the tasks run in a row from the LIFO slot before one task of the ready
+    // queue gets its turn, so ping-ponging tasks can't starve the queue
+    inline constexpr uint32_t lifo_slot_budget = 3;
+
+    // the tasks handed to an io_context by other threads, waiting to be
+    // drained by it
+    inline constexpr uint32_t mpsc_capacity = 4096;
+
+    // Let idle io_contexts steal spawned tasks that haven't run yet from busy
+    // ones. Tasks resumed by I/O or timers always stay on their context.
+    inline constexpr bool work_stealing = false;
+    // the stealable tasks of an io_context, more spawned are not stealable
+    inline constexpr uint32_t steal_capacity = 4096;
+    // the most tasks taken from a victim at once, at most half of its tasks
+    inline constexpr uint32_t steal_batch = 32;
+
+    // task frames up to frame_pool_max_size bytes are recycled per thread
+    // in classes of frame_pool_granule bytes, bigger ones use operator new
+    inline constexpr std::size_t frame_pool_granule = 64;
+    inline constexpr std::size_t frame_pool_max_size = 2048;
+    // the free frames a thread keeps per class
+    inline constexpr uint32_t frame_pool_cache_num = 256;
+    // the frames freed for another thread handed back at once
+    inline constexpr uint32_t frame_remote_batch = 32;
+
     using ctx_id_t = uint16_t;
 
     inline constexpr std::size_t cache_line_size = 64;
 
+    // the CPUs that context_options::cpus can name
+    inline constexpr std::size_t max_cpus = 1024;
+    // the NUMA nodes the contexts can be placed on
+    inline constexpr std::size_t max_numa_nodes = 1024;
+
+    // the number of sqes of the io_uring owned by each io_context
+    inline constexpr uint32_t ring_entries = 1024;
+
+    // the provided buffers that recv borrows from, per io_context
+    inline constexpr uint16_t buffer_group_id = 0;
+    inline constexpr uint32_t buffer_size = 4096;
+    // the pool starts with one chunk and grows a chunk at a time
+    inline constexpr uint16_t buffer_chunk_num = 64;
+    // the entries of the buffer ring, the upper limit of the pool
+    inline constexpr uint16_t buffer_max_num = 4096;
+
 }
 
 }
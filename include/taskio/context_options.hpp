@@ -0,0 +1,38 @@
+#pragma once
+
+#include <bitset>
+#include <chrono>
+
+#include <taskio/config.hpp>
+
+namespace taskio {
+
+/**
+ * @brief How an io_context waits when it runs out of ready tasks, and where
+ * it runs
+ */
+struct context_options {
+    // poll for completions and injected tasks that long before blocking in
+    // the kernel, 0 to block right away
+    std::chrono::microseconds spin_time{0};
+    // the longest a blocking wait lasts before the loop runs again, 0 for
+    // no limit
+    std::chrono::milliseconds wait_timeout{0};
+
+    // A kernel thread polls the submission queue, so submitting and reaping
+    // need no syscall while it is awake, at the cost of a busy core. The
+    // deferred task running of the ring is off in that mode.
+    bool sq_poll = false;
+    // the kernel thread goes to sleep after idling that long
+    std::chrono::milliseconds sq_poll_idle{1000};
+    // pin the kernel thread to that CPU, -1 to leave it to the scheduler
+    int sq_poll_cpu = -1;
+
+    // Pin the thread of the context to these CPUs before it sets up its
+    // ring and pools. If they share a NUMA node, the memory of the context
+    // is taken from that node, its worker included. None to leave the
+    // thread to the scheduler, see cpu_layout().
+    std::bitset<config::max_cpus> cpus{};
+};
+
+} // namespace taskio
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <bitset>
+#include <cstddef>
+
+#include <taskio/config.hpp>
+
+namespace taskio::detail {
+
+/**
+ * @brief Pin the calling thread to `cpus`. If they share a NUMA node, what
+ * the thread allocates from now on comes from that node, and the pages of
+ * [data, data + size) move there.
+ * @return false if the thread couldn't be pinned
+ */
+bool pin_thread(
+    const std::bitset<config::max_cpus> &cpus, void *data, std::size_t size
+) noexcept;
+
+} // namespace taskio::detail
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <atomic>
+#include <coroutine>
+
+#include <taskio/detail/thread_info.hpp>
+
+namespace taskio::detail {
+
+/**
+ * @brief A coroutine suspended on a synchronization primitive. It lives in
+ * the awaiter inside the coroutine's frame, so waiting allocates nothing.
+ */
+struct async_waiter {
+    void suspend(std::coroutine_handle<> current) noexcept {
+        handle = current;
+        home = this_thread.ctx;
+    }
+
+    /**
+     * @brief Resume the coroutine on its context: next on the current one,
+     * through the injection queue of another
+     */
+    void resume() noexcept;
+
+    std::coroutine_handle<> handle;
+    io_context *home = nullptr;
+    std::atomic<async_waiter *> next{nullptr};
+};
+
+/**
+ * @brief An intrusive multi-producer single-consumer FIFO of waiters, push
+ * is wait-free. Vyukov's queue with a stub node.
+ */
+class waiter_queue {
+  public:
+    waiter_queue() noexcept : head(&stub), tail(&stub) {}
+
+    waiter_queue(const waiter_queue &) = delete;
+    waiter_queue &operator=(const waiter_queue &) = delete;
+
+    // thread-safe
+    void push(async_waiter *waiter) noexcept {
+        waiter->next.store(nullptr, std::memory_order_relaxed);
+        async_waiter *prev = head.exchange(waiter, std::memory_order_acq_rel);
+        prev->next.store(waiter, std::memory_order_release);
+    }
+
+    /**
+     * @brief One consumer at a time
+     * @return nullptr if empty or if a push is halfway, retry then
+     */
+    async_waiter *pop() noexcept {
+        async_waiter *first = tail;
+        async_waiter *next = first->next.load(std::memory_order_acquire);
+        if (first == &stub) {
+            if (next == nullptr) {
+                return nullptr;
+            }
+            tail = next;
+            first = next;
+            next = next->next.load(std::memory_order_acquire);
+        }
+        if (next != nullptr) {
+            tail = next;
+            return first;
+        }
+        if (first != head.load(std::memory_order_acquire)) {
+            return nullptr;
+        }
+        push(&stub);
+        next = first->next.load(std::memory_order_acquire);
+        if (next != nullptr) {
+            tail = next;
+            return first;
+        }
+        return nullptr;
+    }
+
+  private:
+    std::atomic<async_waiter *> head;
+    async_waiter *tail;
+    async_waiter stub;
+};
+
+} // namespace taskio::detail
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include <liburing.h>
+
+namespace taskio::io {
+
+class fixed_buffer;
+
+}
+
+namespace taskio::detail {
+
+/**
+ * @brief An arena of buffers registered to the io_uring of an io_context, so
+ * the kernel pins them once instead of on every request. Backed by huge
+ * pages when the system has them reserved, otherwise by transparent huge
+ * pages if possible. Only usable on the thread of the io_context.
+ */
+class buffer_arena {
+  public:
+    // the kernel limit of registered buffers
+    inline static constexpr uint32_t max_buffer_num = 1U << 14;
+
+    /**
+     * @brief Record the arena to register when the ring is set up
+     */
+    void reserve(uint32_t count, uint32_t size) noexcept {
+        assert(count <= max_buffer_num && "too many fixed buffers");
+        buffer_num = count;
+        buffer_size = size;
+    }
+
+    void init(io_uring *ring) noexcept;
+
+    void deinit() noexcept;
+
+    /**
+     * @brief Take a free buffer, empty if all of them are in use
+     */
+    io::fixed_buffer acquire() noexcept;
+
+    void release(uint16_t index) noexcept { free_list.push_back(index); }
+
+    [[nodiscard]]
+    bool is_huge_page() const noexcept {
+        return huge_page;
+    }
+
+    [[nodiscard]]
+    uint32_t available() const noexcept {
+        return free_list.size();
+    }
+
+  private:
+    io_uring *ring = nullptr;
+    char *base = nullptr;
+    std::size_t mapped_size = 0;
+    std::vector<uint16_t> free_list;
+    uint32_t buffer_num = 0;
+    uint32_t buffer_size = 0;
+    bool huge_page = false;
+};
+
+} // namespace taskio::detail
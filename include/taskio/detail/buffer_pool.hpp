@@ -0,0 +1,90 @@
+#pragma once
+
+#include <bit>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <liburing.h>
+
+#include <taskio/config.hpp>
+
+namespace taskio::io {
+
+class buffer;
+
+}
+
+namespace taskio::detail {
+
+/**
+ * @brief The provided buffer ring of an io_context. The kernel takes a
+ * buffer only when data arrives, so idle connections hold none. The ring is
+ * registered on first use and grows a chunk at a time when it runs low,
+ * borrowed buffers go back to the ring when their io::buffer is destroyed.
+ * Only usable on the thread of the io_context.
+ */
+class buffer_pool {
+    static_assert(std::has_single_bit(config::buffer_chunk_num));
+    static_assert(std::has_single_bit(config::buffer_max_num));
+    static_assert(config::buffer_chunk_num <= config::buffer_max_num);
+
+  public:
+    void init(io_uring *ring) noexcept { this->ring = ring; }
+
+    void deinit() noexcept;
+
+    /**
+     * @brief The buffer group to select from, registering the ring on the
+     * first call
+     */
+    uint16_t group_id() noexcept;
+
+    /**
+     * @brief Take the buffer reported by a cqe of a buffer-select request
+     */
+    io::buffer take(int32_t result, uint32_t flags) noexcept;
+
+    /**
+     * @brief Give the buffer back to the kernel
+     */
+    void recycle(uint16_t bid) noexcept;
+
+    /**
+     * @brief Called when a request failed with -ENOBUFS, grows the pool if it
+     * is running low
+     * @return whether the kernel has buffers to retry with
+     */
+    bool replenish() noexcept;
+
+    // buffers owned by the kernel
+    [[nodiscard]]
+    uint32_t available() const noexcept {
+        return available_num;
+    }
+
+    // buffers allocated so far
+    [[nodiscard]]
+    uint32_t size() const noexcept {
+        return buffer_num;
+    }
+
+  private:
+    void grow() noexcept;
+
+    [[nodiscard]]
+    char *address(uint16_t bid) const noexcept {
+        const std::size_t offset = bid % config::buffer_chunk_num;
+        return chunks[bid / config::buffer_chunk_num].get()
+             + offset * config::buffer_size;
+    }
+
+  private:
+    io_uring *ring = nullptr;
+    io_uring_buf_ring *buf_ring = nullptr;
+    std::vector<std::unique_ptr<char[]>> chunks;
+    uint32_t buffer_num = 0;
+    uint32_t available_num = 0;
+};
+
+} // namespace taskio::detail
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <coroutine>
+#include <cstdint>
+
+#include <taskio/config.hpp>
+
+namespace taskio::detail {
+
+/**
+ * @brief A bounded Chase-Lev work-stealing deque of coroutine handles. The
+ * owning thread pushes and pops at the bottom, other threads steal from the
+ * top. A slot is only reused after its steal is settled, so the array never
+ * needs to grow. With config::is_latency_metrics every handle keeps the time
+ * it became ready.
+ */
+template<uint32_t capacity = config::steal_capacity>
+struct steal_deque {
+    static_assert(std::has_single_bit(capacity), "capacity must be 2^n");
+
+    steal_deque() noexcept = default;
+
+    steal_deque(const steal_deque &) = delete;
+    steal_deque &operator=(const steal_deque &) = delete;
+
+    /**
+     * @brief Owning thread only, `ready_at` is kept with the handle
+     * @return false if the deque is full
+     */
+    bool push(std::coroutine_handle<> handle,
+              [[maybe_unused]] uint64_t ready_at = 0) noexcept {
+        int64_t b = bottom.load(std::memory_order_relaxed);
+        int64_t t = top.load(std::memory_order_acquire);
+        if (b - t >= int64_t(capacity)) [[unlikely]] {
+            return false;
+        }
+        slots[b & mask].store(handle.address(), std::memory_order_relaxed);
+        if constexpr (config::is_latency_metrics) {
+            stamps[b & mask].store(ready_at, std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom.store(b + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    /**
+     * @brief Owning thread only, takes the latest pushed handle
+     * @param ready_at set to its stamp, if given
+     * @return nullptr if empty or the last handle was stolen
+     */
+    std::coroutine_handle<> pop(uint64_t *ready_at = nullptr) noexcept {
+        int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+        bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t t = top.load(std::memory_order_relaxed);
+
+        if (t > b) {
+            bottom.store(b + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+
+        void *address = slots[b & mask].load(std::memory_order_relaxed);
+        read_stamp(b, ready_at);
+        if (t == b) {
+            // the last one, race the thieves for it
+            if (!top.compare_exchange_strong(
+                    t,
+                    t + 1,
+                    std::memory_order_seq_cst,
+                    std::memory_order_relaxed
+                )) {
+                address = nullptr;
+            }
+            bottom.store(b + 1, std::memory_order_relaxed);
+        }
+        return std::coroutine_handle<>::from_address(address);
+    }
+
+    /**
+     * @brief Thread-safe, takes the oldest handle
+     * @param ready_at set to its stamp, if given
+     * @return nullptr if empty or another thread won the race
+     */
+    std::coroutine_handle<> steal(uint64_t *ready_at = nullptr) noexcept {
+        int64_t t = top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t b = bottom.load(std::memory_order_acquire);
+        if (t >= b) {
+            return nullptr;
+        }
+
+        void *address = slots[t & mask].load(std::memory_order_relaxed);
+        // read before the slot can be reused, like the handle
+        read_stamp(t, ready_at);
+        if (!top.compare_exchange_strong(
+                t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed
+            )) {
+            return nullptr;
+        }
+        return std::coroutine_handle<>::from_address(address);
+    }
+
+    /**
+     * @brief Thread-safe, only a hint while other threads operate
+     */
+    [[nodiscard]]
+    uint32_t size() const noexcept {
+        int64_t b = bottom.load(std::memory_order_relaxed);
+        int64_t t = top.load(std::memory_order_relaxed);
+        return b > t ? static_cast<uint32_t>(b - t) : 0;
+    }
+
+  private:
+    inline static constexpr int64_t mask = capacity - 1;
+
+    void read_stamp([[maybe_unused]] int64_t pos,
+                    [[maybe_unused]] uint64_t *ready_at) const noexcept {
+        if constexpr (config::is_latency_metrics) {
+            if (ready_at != nullptr) {
+                *ready_at = stamps[pos & mask].load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    alignas(config::cache_line_size) std::atomic<int64_t> top{0};
+    alignas(config::cache_line_size) std::atomic<int64_t> bottom{0};
+    alignas(config::cache_line_size) std::atomic<void *> slots[capacity]{};
+    [[no_unique_address]] std::array<
+        std::atomic<uint64_t>,
+        config::is_latency_metrics ? capacity : 0> stamps{};
+};
+
+} // namespace taskio::detail
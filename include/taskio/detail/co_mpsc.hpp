@@ -0,0 +1,107 @@
+#pragma once
+
+#include <atomic>
+#include <bit>
+#include <concepts>
+#include <coroutine>
+#include <memory>
+#include <type_traits>
+
+#include <taskio/config.hpp>
+
+namespace taskio::detail {
+
+/**
+ * @brief A bounded lock-free queue, any thread can post to it, only the
+ * owning thread fetches from it. Every cell carries a sequence number
+ * telling whether it is free or published for its round.
+ * @tparam Value what is queued, a coroutine handle or a small struct
+ * @tparam T The size type of the mpsc
+ */
+template<
+    typename Value = std::coroutine_handle<>,
+    std::unsigned_integral T = uint32_t,
+    T capacity = config::mpsc_capacity>
+struct mpsc {
+    static_assert(std::has_single_bit(capacity), "capacity must be 2^n");
+    static_assert(std::is_trivially_copyable_v<Value>);
+
+    // the cells are allocated once, contexts don't carry them inline
+    mpsc() noexcept : cells(new cell[capacity]) {
+        for (T i = 0; i < capacity; ++i) {
+            cells[i].seq.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    mpsc(const mpsc &) = delete;
+    mpsc &operator=(const mpsc &) = delete;
+
+    /**
+     * @brief Thread-safe
+     * @return false if the queue is full
+     */
+    bool try_post(const Value &value) noexcept {
+        T pos = tail.load(std::memory_order_relaxed);
+        for (;;) {
+            cell &slot = cells[pos & mask];
+            T seq = slot.seq.load(std::memory_order_acquire);
+            auto diff = static_cast<signed_t>(seq - pos);
+            if (diff == 0) {
+                // seq_cst pairs with the consumer checking empty() after
+                // announcing it is going to sleep
+                if (tail.compare_exchange_weak(
+                        pos, pos + 1, std::memory_order_seq_cst
+                    )) {
+                    slot.value = value;
+                    slot.seq.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = tail.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /**
+     * @brief Owning thread only
+     * @return false if empty or the next producer hasn't published yet
+     */
+    bool try_fetch(Value &value) noexcept {
+        cell &slot = cells[head & mask];
+        T seq = slot.seq.load(std::memory_order_acquire);
+        if (static_cast<signed_t>(seq - (head + 1)) < 0) {
+            return false;
+        }
+        value = slot.value;
+        slot.seq.store(head + capacity, std::memory_order_release);
+        ++head;
+        return true;
+    }
+
+    /**
+     * @brief Owning thread only, a value being posted counts as queued
+     */
+    [[nodiscard]]
+    bool empty() const noexcept {
+        return tail.load(std::memory_order_seq_cst) == head;
+    }
+
+  private:
+    using signed_t = std::make_signed_t<T>;
+
+    inline static constexpr T mask = capacity - 1;
+
+    struct cell {
+        std::atomic<T> seq;
+        Value value;
+    };
+
+    // read-only after construction, shared by every thread
+    const std::unique_ptr<cell[]> cells;
+    alignas(config::cache_line_size) std::atomic<T> tail{0};
+    alignas(config::cache_line_size) T head = 0;
+};
+
+} // namespace taskio::detail
@@ -3,9 +3,12 @@
 #include <cassert>
 #include <array>
 #include <coroutine>
+#include <exception>
+#include <utility>
 
 #include <taskio/config.hpp>
 #include <taskio/detail/safety.hpp>
+#include <taskio/log/log.hpp>
 #include <taskio/util/to_atomic.hpp>
 
 namespace taskio::detail {
@@ -15,17 +18,39 @@ namespace taskio::detail {
  * @tparam T The size type of the spsc
  * @tparam is_thread_safe Whether thread-safe practices are employed.
  * For performance reasons, thread-unsafe practices are used by default
+ * @tparam Value what is queued, a coroutine handle by default
  */
 template<
     std::unsigned_integral T = config::cur_t,
     T capacity = config::spsc_capacity,
-    bool is_thread_safe = safety::unsafe>
+    bool is_thread_safe = safety::unsafe,
+    typename Value = std::coroutine_handle<>>
 struct spsc {
 
+    /**
+     * @brief Terminates if the spsc is full, also without asserts: a live
+     * handle must never be overwritten. Use try_post_task() where the queue
+     * may fill up.
+     */
     inline void post_task(std::coroutine_handle<> handle) noexcept {
+        if (!try_post_task(handle)) [[unlikely]] {
+            log::err("spsc is full, {} tasks\n", capacity);
+            std::terminate();
+        }
+    }
+
+    /**
+     * @return false if the spsc is full, nothing is overwritten
+     */
+    [[nodiscard]]
+    inline bool try_post_task(std::coroutine_handle<> handle) noexcept {
         assert(bool(handle) && "handle cannot be empty");
+        if (!cursor_.is_available()) [[unlikely]] {
+            return false;
+        }
         reap_queue[cursor_.tail()] = handle;
         cursor_.push();
+        return true;
     }
 
     inline std::coroutine_handle<> fetch_task() noexcept {
@@ -39,12 +64,57 @@ struct spsc {
         return cursor_.size();
     }
 
+    // producer only
+    [[nodiscard]]
+    inline bool can_push() const noexcept {
+        return static_cast<T>(cursor_.raw_tail() - cursor_.load_raw_head())
+               != capacity;
+    }
+
+    // consumer only
+    [[nodiscard]]
+    inline bool can_pop() const noexcept {
+        return cursor_.raw_head() != cursor_.load_raw_tail();
+    }
+
+    /**
+     * @brief Producer only
+     * @return false if the spsc is full, `value` is left untouched
+     */
+    [[nodiscard]]
+    inline bool try_push(Value &&value) noexcept {
+        if (!can_push()) [[unlikely]] {
+            return false;
+        }
+        reap_queue[cursor_.tail()] = std::move(value);
+        cursor_.push();
+        return true;
+    }
+
+    /**
+     * @brief Consumer only
+     * @return false if the spsc is empty
+     */
+    [[nodiscard]]
+    inline bool try_pop(Value &value) noexcept {
+        if (!can_pop()) {
+            return false;
+        }
+        value = std::move(reap_queue[cursor_.head()]);
+        cursor_.pop();
+        return true;
+    }
+
   private:
     template<std::unsigned_integral Type, Type capacity_>
     struct cursor {
         using sz_t = Type;
-        sz_t m_head = 0;
-        sz_t m_tail = 0;
+        // the ends don't share a cache line when two threads use them
+        inline static constexpr std::size_t align =
+            is_thread_safe ? config::cache_line_size : alignof(sz_t);
+
+        alignas(align) sz_t m_head = 0;
+        alignas(align) sz_t m_tail = 0;
 
         inline static constexpr sz_t mask = capacity_ - 1;
 
@@ -72,7 +142,7 @@ struct spsc {
 
         [[nodiscard]]
         inline bool is_available() const noexcept {
-            return bool(capacity_ - (m_tail - m_head));
+            return size() != capacity_;
         }
 
         [[nodiscard]]
@@ -145,7 +215,7 @@ struct spsc {
     using cur_t = config::cur_t;
 
     alignas(config::cache_line_size
-    ) std::array<std::coroutine_handle<>, capacity> reap_queue;
+    ) std::array<Value, capacity> reap_queue;
 
     cursor<T, capacity> cursor_;
 };
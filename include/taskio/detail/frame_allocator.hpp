@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+
+namespace taskio::detail {
+
+/**
+ * @brief Allocates coroutine frames through `Alloc`. A stateful allocator is
+ * copied behind the frame, so it can be recovered from the pointer and size
+ * handed to the sized `operator delete`.
+ */
+template<typename Alloc>
+struct frame_allocator {
+    struct alignas(__STDCPP_DEFAULT_NEW_ALIGNMENT__) block {
+        unsigned char bytes[__STDCPP_DEFAULT_NEW_ALIGNMENT__];
+    };
+
+    using block_alloc =
+        typename std::allocator_traits<Alloc>::template rebind_alloc<block>;
+    using traits = std::allocator_traits<block_alloc>;
+
+    inline static constexpr bool stateless =
+        traits::is_always_equal::value &&
+        std::is_default_constructible_v<block_alloc>;
+
+    static_assert(alignof(block_alloc) <= alignof(block));
+
+    [[nodiscard]]
+    static void *allocate(const Alloc &alloc, std::size_t size) {
+        block_alloc rebound(alloc);
+        void *ptr = traits::allocate(rebound, block_num(size));
+        if constexpr (!stateless) {
+            ::new (stored_at(ptr, size)) block_alloc(std::move(rebound));
+        }
+        return ptr;
+    }
+
+    static void deallocate(void *ptr, std::size_t size) noexcept {
+        auto *frame = static_cast<block *>(ptr);
+        if constexpr (stateless) {
+            block_alloc rebound;
+            traits::deallocate(rebound, frame, block_num(size));
+        } else {
+            auto *stored =
+                std::launder(static_cast<block_alloc *>(stored_at(ptr, size)));
+            block_alloc rebound(std::move(*stored));
+            stored->~block_alloc();
+            traits::deallocate(rebound, frame, block_num(size));
+        }
+    }
+
+  private:
+    static constexpr std::size_t alloc_offset(std::size_t size) noexcept {
+        constexpr std::size_t align = alignof(block_alloc);
+        return (size + align - 1) & ~(align - 1);
+    }
+
+    static constexpr std::size_t block_num(std::size_t size) noexcept {
+        std::size_t bytes =
+            stateless ? size : alloc_offset(size) + sizeof(block_alloc);
+        return (bytes + sizeof(block) - 1) / sizeof(block);
+    }
+
+    static void *stored_at(void *ptr, std::size_t size) noexcept {
+        return static_cast<char *>(ptr) + alloc_offset(size);
+    }
+};
+
+} // namespace taskio::detail
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include <taskio/config.hpp>
+#include <taskio/detail/thread_info.hpp>
+
+namespace taskio::detail {
+
+/**
+ * @brief Per-thread size-class freelists for coroutine frames. Every frame
+ * carries a small header naming the pool it belongs to, a frame freed on
+ * another thread is batched and handed back to its pool with one CAS. A
+ * pool outlives its thread and is adopted by the next thread that starts,
+ * so late frees always have a pool to go to.
+ */
+class frame_pool {
+  public:
+    [[nodiscard]]
+    static void *allocate(std::size_t size);
+
+    static void deallocate(void *ptr) noexcept;
+
+    /**
+     * @brief Hand the frames freed by this thread back to their pools, and
+     * take in the frames of this thread freed by others
+     */
+    static void flush_remote() noexcept;
+
+  private:
+    struct alignas(16) header {
+        frame_pool *owner;
+        uint32_t size_class;
+    };
+
+    inline static constexpr std::size_t granule = config::frame_pool_granule;
+    inline static constexpr uint32_t class_num =
+        config::frame_pool_max_size / granule;
+    inline static constexpr uint32_t large_class = UINT32_MAX;
+
+    static_assert(config::frame_pool_max_size % granule == 0);
+
+    // the link of a free frame lives in its payload
+    static header *&next_of(header *h) noexcept {
+        return *reinterpret_cast<header **>(h + 1);
+    }
+
+    static frame_pool *adopt();
+
+    static void *allocate_large(std::size_t total);
+
+    void deallocate_slow(header *h) noexcept;
+
+    header *refill(uint32_t size_class);
+
+    void drain_remote() noexcept;
+
+    void flush_batch() noexcept;
+
+  private:
+    header *free_list[class_num]{};
+    uint32_t free_num[class_num]{};
+
+    // frames of another pool freed by this thread
+    frame_pool *batch_owner = nullptr;
+    header *batch_head = nullptr;
+    header *batch_tail = nullptr;
+    uint32_t batch_num = 0;
+
+    // frames of this pool freed by other threads
+    alignas(config::cache_line_size) std::atomic<header *> remote_head{};
+};
+
+inline void *frame_pool::allocate(std::size_t size) {
+    const std::size_t total = size + sizeof(header);
+    if (total > config::frame_pool_max_size) [[unlikely]] {
+        return allocate_large(total);
+    }
+
+    frame_pool *pool = this_thread.frames;
+    if (pool == nullptr) [[unlikely]] {
+        pool = adopt();
+    }
+
+    const auto size_class = static_cast<uint32_t>((total - 1) / granule);
+    header *h = pool->free_list[size_class];
+    if (h != nullptr) [[likely]] {
+        pool->free_list[size_class] = next_of(h);
+        --pool->free_num[size_class];
+    } else {
+        h = pool->refill(size_class);
+    }
+    return h + 1;
+}
+
+inline void frame_pool::deallocate(void *ptr) noexcept {
+    header *h = static_cast<header *>(ptr) - 1;
+    frame_pool *pool = this_thread.frames;
+    if (h->owner == pool && pool != nullptr
+        && pool->free_num[h->size_class] < config::frame_pool_cache_num)
+        [[likely]] {
+        next_of(h) = pool->free_list[h->size_class];
+        pool->free_list[h->size_class] = h;
+        ++pool->free_num[h->size_class];
+        return;
+    }
+
+    if (h->size_class == large_class) {
+        ::operator delete(h);
+        return;
+    }
+
+    if (pool == nullptr) {
+        pool = adopt();
+    }
+    pool->deallocate_slow(h);
+}
+
+} // namespace taskio::detail
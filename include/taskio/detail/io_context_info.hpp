@@ -1,10 +1,19 @@
 #pragma once
 
+#include <atomic>
 #include <condition_variable>
+#include <cstdint>
 #include <mutex>
+#include <vector>
 
 #include <taskio/config.hpp>
 
+namespace taskio {
+
+struct io_context;
+
+}
+
 namespace taskio::detail {
 
 struct io_context_info {
@@ -12,6 +21,15 @@ struct io_context_info {
     std::condition_variable cv;
     config::ctx_id_t create_count{};
     config::ctx_id_t ready_count{};
+
+    // the running contexts, guarded by mtx
+    std::vector<io_context *> contexts;
+    // busy contexts + tasks injected but not drained yet + holds, the
+    // contexts exit together once it drops to zero
+    std::atomic<int64_t> pending_work{0};
+    std::atomic<bool> quiescent{false};
+    // the contexts out of work, the busy ones wake them up to steal
+    std::atomic<uint32_t> idle_count{0};
 };
 
 inline io_context_info io_context_info;
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <coroutine>
+#include <cstddef>
+
+#include <taskio/detail/stop_state.hpp>
+#include <taskio/task.hpp>
+
+namespace taskio::detail {
+
+/**
+ * @brief Counts the running tasks of a group and resumes the awaiting
+ * coroutine after the last one. The count starts one above the number of
+ * tasks, the extra one is dropped once every task is started, so that a task
+ * finishing inline can't resume the awaiting coroutine early. It lives in
+ * the frame of the awaiting coroutine.
+ */
+class join_counter : public task_join {
+  public:
+    explicit join_counter(std::size_t count) noexcept : remaining(count + 1) {
+        this->on_finish = &join_counter::finish;
+    }
+
+    join_counter(const join_counter &) = delete;
+    join_counter &operator=(const join_counter &) = delete;
+
+    // the task inherits `stop` unless it has its own stop_state. It must own
+    // a frame that hasn't started: not moved from, detached or awaited.
+    template<typename T>
+    void launch(task<T> &member, stop_state *stop) noexcept {
+        auto handle = member.get_handle();
+        assert(bool(handle) && "task is empty, moved from or detached");
+        assert(!handle.done() && "task already finished");
+        auto &promise = handle.promise();
+        promise.set_join(this);
+        if (promise.get_stop_state() == nullptr) {
+            promise.set_stop_state(stop);
+        }
+        handle.resume();
+    }
+
+    /**
+     * @brief Called after every task is launched
+     * @return false if they all finished already, `awaiting` isn't suspended
+     */
+    bool suspend(std::coroutine_handle<> awaiting) noexcept {
+        continuation = awaiting;
+        return remaining.fetch_sub(1, std::memory_order_acq_rel) != 1;
+    }
+
+  protected:
+    std::coroutine_handle<> arrive() noexcept {
+        if (remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            return continuation;
+        }
+        return std::noop_coroutine();
+    }
+
+  private:
+    static std::coroutine_handle<>
+    finish(task_join *self, std::coroutine_handle<>) noexcept {
+        return static_cast<join_counter *>(self)->arrive();
+    }
+
+    std::atomic<std::size_t> remaining;
+    std::coroutine_handle<> continuation;
+};
+
+/**
+ * @brief The value of a finished task, rethrows what the task threw
+ */
+template<typename T>
+inline decltype(auto) take_result(task<T> &finished) {
+    return std::move(finished.get_handle().promise()).result();
+}
+
+} // namespace taskio::detail
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cerrno>
+#include <coroutine>
+#include <cstdint>
+
+#include <taskio/detail/stop_state.hpp>
+#include <taskio/detail/task_info.hpp>
+#include <taskio/detail/thread_info.hpp>
+#include <taskio/detail/trace_ring.hpp>
+#include <taskio/detail/worker_meta.hpp>
+
+namespace taskio::detail {
+
+/**
+ * @brief Cancels the request of `target` when stop is requested, the request
+ * then completes with -ECANCELED unless it has already finished
+ */
+struct io_cancel_node : stop_callback_node {
+    task_info *target = nullptr;
+    stop_state *source = nullptr;
+
+    /**
+     * @return false if stop was already requested, nothing is registered
+     */
+    bool arm(stop_state *stop, task_info *info) noexcept {
+        on_stop = &io_cancel_node::cancel;
+        target = info;
+        source = stop;
+        return stop->add(this);
+    }
+
+    void disarm() noexcept {
+        if (source != nullptr) {
+            source->remove(this);
+            source = nullptr;
+        }
+    }
+
+    static void cancel(stop_callback_node *node) noexcept {
+        auto *self = static_cast<io_cancel_node *>(node);
+        self->source = nullptr;
+
+        io_uring_sqe *sqe = this_thread.worker->get_free_sqe();
+        io_uring_prep_cancel(sqe, self->target, 0);
+        io_uring_sqe_set_data(sqe, nullptr);
+    }
+};
+
+/**
+ * @brief The base of the I/O awaiters. The sqe is only prepared when the
+ * awaiter is suspended, so the request state lives in the awaiting
+ * coroutine's frame and nothing is allocated. The request is cancelled when
+ * the awaiting task is asked to stop.
+ * @tparam Derived must provide `void prep(io_uring_sqe *sqe) noexcept`
+ */
+template<typename Derived>
+struct lazy_awaiter {
+    static constexpr bool await_ready() noexcept { return false; }
+
+    template<typename Promise>
+    bool await_suspend(std::coroutine_handle<Promise> current) noexcept {
+        stop_state *stop = stop_state_of(current);
+        if (stop != nullptr && stop->stop_requested()) [[unlikely]] {
+            io_info.result = -ECANCELED;
+            return false;
+        }
+
+        io_info.handle = current;
+
+        io_uring_sqe *sqe = this_thread.worker->get_free_sqe();
+        static_cast<Derived *>(this)->prep(sqe);
+        io_uring_sqe_set_data(sqe, &io_info);
+        trace_event(trace::event_type::io_submit, &io_info, sqe->opcode);
+
+        if (stop != nullptr) {
+            cancel.arm(stop, &io_info);
+        }
+        return true;
+    }
+
+    // the result of the request, -errno on failure
+    int32_t await_resume() noexcept {
+        cancel.disarm();
+        return io_info.result;
+    }
+
+  protected:
+    task_info io_info;
+    io_cancel_node cancel;
+};
+
+} // namespace taskio::detail
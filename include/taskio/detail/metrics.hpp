@@ -0,0 +1,129 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <type_traits>
+
+#include <taskio/config.hpp>
+#include <taskio/detail/thread_info.hpp>
+#include <taskio/metrics.hpp>
+
+namespace taskio::detail {
+
+/**
+ * @brief Written by the owning thread with plain loads and stores, read by
+ * any thread
+ */
+class metric_counter {
+  public:
+    void add(uint64_t num = 1) noexcept {
+        value.store(value.load(std::memory_order_relaxed) + num,
+                    std::memory_order_relaxed);
+    }
+
+    // for the counters written by other threads too
+    void add_shared(uint64_t num = 1) noexcept {
+        value.fetch_add(num, std::memory_order_relaxed);
+    }
+
+    void raise(uint64_t num) noexcept {
+        if (num > value.load(std::memory_order_relaxed)) {
+            value.store(num, std::memory_order_relaxed);
+        }
+    }
+
+    [[nodiscard]]
+    uint64_t load() const noexcept {
+        return value.load(std::memory_order_relaxed);
+    }
+
+  private:
+    std::atomic<uint64_t> value{0};
+};
+
+// the clock of the metrics, in ns
+inline uint64_t metrics_now() noexcept {
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch())
+            .count());
+}
+
+// when a task becomes ready, 0 unless config::is_latency_metrics
+inline uint64_t ready_stamp() noexcept {
+    if constexpr (config::is_latency_metrics) {
+        return metrics_now();
+    } else {
+        return 0;
+    }
+}
+
+class latency_recorder {
+  public:
+    void record(uint64_t ns) noexcept {
+        buckets[latency_histogram::bucket_of(ns)].add();
+    }
+
+    void read(latency_histogram &out) const noexcept {
+        for (uint32_t i = 0; i < latency_histogram::bucket_num; ++i) {
+            out.counts[i] = buckets[i].load();
+        }
+    }
+
+  private:
+    std::array<metric_counter, latency_histogram::bucket_num> buckets;
+};
+
+// the histogram when latencies are not measured, no room taken
+struct no_latency_recorder {
+    void record(uint64_t) noexcept {}
+
+    void read(latency_histogram &) const noexcept {}
+};
+
+/**
+ * @brief The counters of a worker, on cache lines of their own so that
+ * readers on other threads don't slow the loop down
+ */
+struct alignas(config::cache_line_size) worker_metrics {
+    metric_counter spawned;
+    metric_counter resumed;
+    metric_counter completed;
+    metric_counter ready_high_water;
+    metric_counter loop_iterations;
+    metric_counter cqes_reaped;
+    metric_counter busy_ns;
+    metric_counter idle_ns;
+    // the end of the last idle stretch, owning thread only
+    uint64_t active_since = 0;
+
+    [[no_unique_address]] std::conditional_t<
+        config::is_latency_metrics,
+        latency_recorder,
+        no_latency_recorder> ready_latency;
+
+    void read(context_metrics &out) const noexcept {
+        out.spawned = spawned.load();
+        out.resumed = resumed.load();
+        out.completed = completed.load();
+        out.ready_high_water = ready_high_water.load();
+        out.loop_iterations = loop_iterations.load();
+        out.cqes_reaped = cqes_reaped.load();
+        out.busy = std::chrono::nanoseconds(busy_ns.load());
+        out.idle = std::chrono::nanoseconds(idle_ns.load());
+        ready_latency.read(out.ready_latency);
+    }
+};
+
+// a task of the current thread finished
+inline void count_completed() noexcept {
+    if constexpr (config::is_counter_metrics) {
+        if (this_thread.metrics != nullptr) {
+            this_thread.metrics->completed.add();
+        }
+    }
+}
+
+} // namespace taskio::detail
@@ -0,0 +1,194 @@
+#pragma once
+
+#include <cassert>
+#include <coroutine>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include <taskio/detail/lazy_awaiter.hpp>
+#include <taskio/detail/stop_state.hpp>
+#include <taskio/detail/task_info.hpp>
+#include <taskio/detail/thread_info.hpp>
+#include <taskio/detail/trace_ring.hpp>
+#include <taskio/detail/worker_meta.hpp>
+
+namespace taskio::detail {
+
+struct cqe_entry {
+    int32_t result;
+    uint32_t flags;
+};
+
+/**
+ * @brief An asynchronous stream over the cqes of one multishot request.
+ * The request is armed on the first `co_await next()` and re-armed lazily
+ * once the kernel terminates it.
+ * @tparam Op provides `void prep(io_uring_sqe *)`, `result_type
+ * transform(cqe_entry)` applied when the cqe arrives, `void
+ * drop(result_type &&)` that releases an unconsumed result (an accepted fd)
+ * and `bool rearm(cqe_entry)` that decides whether a terminating cqe is
+ * retried silently instead of being reported, `result_type cancelled()`
+ * stands for a request never armed because the consumer was stopped
+ */
+template<typename Op>
+class multishot_stream {
+    using result_type = typename Op::result_type;
+
+    // The kernel may post cqes after the stream is gone, so the state is
+    // allocated once per stream and freed by the final cqe if orphaned.
+    struct state : task_info {
+        explicit state(Op &&op) noexcept : op(std::move(op)) {
+            this->on_complete = &state::on_cqe;
+        }
+
+        void arm() noexcept {
+            io_uring_sqe *sqe = this_thread.worker->get_free_sqe();
+            op.prep(sqe);
+            io_uring_sqe_set_data(sqe, static_cast<task_info *>(this));
+            trace_event(trace::event_type::io_submit,
+                        static_cast<task_info *>(this), sqe->opcode);
+            armed = true;
+        }
+
+        static void
+        on_cqe(task_info *info, int32_t result, uint32_t flags) noexcept {
+            auto *self = static_cast<state *>(info);
+            if (!(flags & IORING_CQE_F_MORE)) {
+                self->armed = false;
+            }
+
+            if (self->orphaned) [[unlikely]] {
+                self->op.drop(self->op.transform({result, flags}));
+                if (!self->armed) {
+                    delete self;
+                }
+                return;
+            }
+
+            if (!self->armed && self->op.rearm({result, flags})) {
+                self->arm();
+                return;
+            }
+
+            self->entries.push_back(self->op.transform({result, flags}));
+            if (self->handle) {
+                this_thread.worker->post_task(std::exchange(self->handle, {}));
+            }
+        }
+
+        Op op;
+        // results not consumed yet, the storage is kept across batches
+        std::vector<result_type> entries;
+        std::size_t head = 0;
+        bool armed = false;
+        bool orphaned = false;
+    };
+
+    struct next_awaiter {
+        explicit next_awaiter(state *self) noexcept : self(self) {}
+
+        bool await_ready() const noexcept {
+            return self->head != self->entries.size();
+        }
+
+        // stopping the consumer cancels the request, the kernel terminates
+        // it with -ECANCELED
+        template<typename Promise>
+        bool await_suspend(std::coroutine_handle<Promise> current) noexcept {
+            assert(!self->handle && "the stream has only one consumer");
+            stop_state *stop = stop_state_of(current);
+            if (stop != nullptr && stop->stop_requested()) [[unlikely]] {
+                cancelled = true;
+                return false;
+            }
+
+            self->handle = current;
+            if (!self->armed) {
+                self->arm();
+            }
+            if (stop != nullptr) {
+                cancel.arm(stop, self);
+            }
+            return true;
+        }
+
+        result_type await_resume() noexcept {
+            cancel.disarm();
+            if (cancelled) [[unlikely]] {
+                return Op::cancelled();
+            }
+
+            result_type result = std::move(self->entries[self->head++]);
+            if (self->head == self->entries.size()) {
+                self->entries.clear();
+                self->head = 0;
+            }
+            return result;
+        }
+
+        state *self;
+        io_cancel_node cancel;
+        bool cancelled = false;
+    };
+
+  public:
+    explicit multishot_stream(Op op) : self(new state{std::move(op)}) {}
+
+    multishot_stream(const multishot_stream &) = delete;
+    multishot_stream &operator=(const multishot_stream &) = delete;
+
+    multishot_stream(multishot_stream &&other) noexcept
+        : self(std::exchange(other.self, nullptr)) {}
+
+    multishot_stream &operator=(multishot_stream &&other) noexcept {
+        if (this != std::addressof(other)) [[likely]] {
+            release();
+            self = std::exchange(other.self, nullptr);
+        }
+        return *this;
+    }
+
+    /**
+     * @brief Cancel the request if it is armed, must run on the thread that
+     * armed it
+     */
+    ~multishot_stream() { release(); }
+
+    /**
+     * @brief Await the next completion of the request
+     */
+    [[nodiscard]]
+    next_awaiter next() noexcept {
+        return next_awaiter{self};
+    }
+
+  private:
+    void release() noexcept {
+        if (self == nullptr) {
+            return;
+        }
+
+        for (auto i = self->head; i < self->entries.size(); ++i) {
+            self->op.drop(std::move(self->entries[i]));
+        }
+        self->entries.clear();
+        self->head = 0;
+
+        if (!self->armed) {
+            delete self;
+            return;
+        }
+
+        // the final cqe frees the state
+        self->orphaned = true;
+        io_uring_sqe *sqe = this_thread.worker->get_free_sqe();
+        io_uring_prep_cancel(sqe, static_cast<task_info *>(self), 0);
+        io_uring_sqe_set_data(sqe, nullptr);
+        self = nullptr;
+    }
+
+    state *self;
+};
+
+} // namespace taskio::detail
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+
+#include <taskio/config.hpp>
+#include <taskio/detail/metrics.hpp>
+
+namespace taskio::detail {
+
+/**
+ * @brief The unbounded FIFO of the ready tasks of a worker, a chain of
+ * fixed-size segments. It allocates nothing until the first post and keeps
+ * one drained segment around, so a steady load doesn't touch the allocator.
+ * Only the owning thread posts and fetches. With config::is_latency_metrics
+ * every task is stamped with the time it became ready.
+ */
+template<uint32_t segment_size = config::ready_segment_size>
+class ready_queue {
+  public:
+    ready_queue() noexcept = default;
+
+    ~ready_queue() {
+        while (head != nullptr) {
+            segment *next = head->next;
+            delete head;
+            head = next;
+        }
+        delete spare;
+    }
+
+    ready_queue(const ready_queue &) = delete;
+    ready_queue &operator=(const ready_queue &) = delete;
+
+    inline void post_task(std::coroutine_handle<> handle) noexcept {
+        if constexpr (config::is_latency_metrics) {
+            post_stamped(handle, metrics_now());
+        } else {
+            post_stamped(handle, 0);
+        }
+    }
+
+    // `ready_at` is kept for a task that was ready before, in ns
+    inline void
+    post_stamped(std::coroutine_handle<> handle,
+                 [[maybe_unused]] uint64_t ready_at) noexcept {
+        assert(bool(handle) && "handle cannot be empty");
+        if (tail == nullptr || tail_pos == segment_size) [[unlikely]] {
+            grow();
+        }
+        if constexpr (config::is_latency_metrics) {
+            tail->stamps[tail_pos] = ready_at;
+        }
+        tail->handles[tail_pos++] = handle;
+        depth.store(
+            depth.load(std::memory_order_relaxed) + 1,
+            std::memory_order_relaxed
+        );
+    }
+
+    inline std::coroutine_handle<> fetch_task() noexcept {
+        assert(task_num() != 0 && "ready_queue is empty");
+        if (head_pos == segment_size) [[unlikely]] {
+            shrink();
+        }
+        if constexpr (config::is_latency_metrics) {
+            last_stamp = head->stamps[head_pos];
+        }
+        std::coroutine_handle<> handle = head->handles[head_pos++];
+
+        const std::size_t num = depth.load(std::memory_order_relaxed) - 1;
+        depth.store(num, std::memory_order_relaxed);
+        if (num == 0) {
+            // rewind instead of walking into a new segment
+            head_pos = tail_pos = 0;
+        }
+        return handle;
+    }
+
+    [[nodiscard]]
+    inline std::size_t task_num() const noexcept {
+        return depth.load(std::memory_order_relaxed);
+    }
+
+    // when the last task fetched became ready, see post_stamped()
+    [[nodiscard]]
+    inline uint64_t fetched_stamp() const noexcept {
+        return last_stamp;
+    }
+
+  private:
+    struct segment {
+        segment *next = nullptr;
+        std::coroutine_handle<> handles[segment_size];
+        [[no_unique_address]] std::array<
+            uint64_t,
+            config::is_latency_metrics ? segment_size : 0> stamps;
+    };
+
+    void grow() noexcept {
+        segment *seg = spare != nullptr ? spare : new segment;
+        spare = nullptr;
+        seg->next = nullptr;
+
+        if (tail == nullptr) {
+            head = seg;
+        } else {
+            tail->next = seg;
+        }
+        tail = seg;
+        tail_pos = 0;
+    }
+
+    void shrink() noexcept {
+        segment *drained = head;
+        head = head->next;
+        head_pos = 0;
+
+        if (spare == nullptr) {
+            spare = drained;
+        } else {
+            delete drained;
+        }
+    }
+
+    segment *head = nullptr;
+    segment *tail = nullptr;
+    segment *spare = nullptr;
+    uint32_t head_pos = 0;
+    uint32_t tail_pos = 0;
+    uint64_t last_stamp = 0;
+    // written by the owner only, read by others as a backpressure hint
+    std::atomic<std::size_t> depth{0};
+};
+
+} // namespace taskio::detail
@@ -0,0 +1,146 @@
+#pragma once
+
+#include <atomic>
+#include <coroutine>
+#include <cstdint>
+
+namespace taskio::detail {
+
+struct worker_meta;
+
+/**
+ * @brief A callback registered to a stop_state, it lives in the frame of the
+ * coroutine that registers it so registration allocates nothing. The callback
+ * always runs on the worker that registered it: a stop requested from another
+ * thread hands it over to that worker.
+ */
+struct stop_callback_node {
+    using callback = void (*)(stop_callback_node *node) noexcept;
+
+    enum class node_state : uint8_t { idle, linked, queued };
+
+    callback on_stop = nullptr;
+    // the links of the stop_state, or of the worker once handed over
+    stop_callback_node *prev = nullptr;
+    stop_callback_node *next = nullptr;
+    worker_meta *home = nullptr;
+    node_state state = node_state::idle;
+};
+
+/**
+ * @brief The cancellation state shared by a tree of tasks. A task inherits
+ * the state of the task awaiting it, awaiters register callbacks that abort
+ * their pending operation. Thread-safe, the tasks sharing it may run on
+ * different contexts.
+ */
+class stop_state {
+  public:
+    stop_state() noexcept = default;
+
+    stop_state(const stop_state &) = delete;
+    stop_state &operator=(const stop_state &) = delete;
+
+    [[nodiscard]]
+    bool stop_requested() const noexcept {
+        return requested.load(std::memory_order_acquire);
+    }
+
+    /**
+     * @brief Register `node` for the calling worker
+     * @return false if stop was already requested, `node` is not registered
+     */
+    bool add(stop_callback_node *node) noexcept;
+
+    /**
+     * @brief Unregister `node` on the worker that registered it. Once it
+     * returns the callback won't run, no-op if it is not registered anymore.
+     */
+    void remove(stop_callback_node *node) noexcept;
+
+    /**
+     * @brief Run every registered callback once, in LIFO order. The callbacks
+     * of other workers are handed over to them and run later.
+     */
+    void request_stop() noexcept;
+
+  private:
+    // held for a few pointer updates only
+    void lock() noexcept {
+        while (locked.test_and_set(std::memory_order_acquire)) {
+            while (locked.test(std::memory_order_relaxed)) {
+            }
+        }
+    }
+
+    void unlock() noexcept { locked.clear(std::memory_order_release); }
+
+    void unlink(stop_callback_node *node) noexcept;
+
+    stop_callback_node *head = nullptr;
+    std::atomic<bool> requested{false};
+    std::atomic_flag locked;
+};
+
+/**
+ * @brief The stop_state of the coroutine behind `handle`, nullptr if its
+ * promise doesn't carry one
+ */
+template<typename Promise>
+inline stop_state *stop_state_of(std::coroutine_handle<Promise> handle
+) noexcept {
+    if constexpr (requires { handle.promise().get_stop_state(); }) {
+        return handle.promise().get_stop_state();
+    } else {
+        return nullptr;
+    }
+}
+
+/**
+ * @brief Forwards a stop requested on `source` to `target`, unregistered
+ * when it goes out of scope
+ */
+struct stop_forwarder : stop_callback_node {
+    stop_forwarder(stop_state *source, stop_state &target) noexcept
+        : source(source), target(target) {
+        this->on_stop = &stop_forwarder::forward;
+        if (source != nullptr && !source->add(this)) {
+            target.request_stop();
+        }
+    }
+
+    ~stop_forwarder() {
+        if (source != nullptr) {
+            source->remove(this);
+        }
+    }
+
+    stop_forwarder(const stop_forwarder &) = delete;
+    stop_forwarder &operator=(const stop_forwarder &) = delete;
+
+  private:
+    static void forward(stop_callback_node *node) noexcept {
+        static_cast<stop_forwarder *>(node)->target.request_stop();
+    }
+
+    stop_state *source;
+    stop_state &target;
+};
+
+/**
+ * @brief `co_await` it to get the stop_state of the current task
+ */
+struct current_stop_state {
+    static constexpr bool await_ready() noexcept { return false; }
+
+    template<typename Promise>
+    bool await_suspend(std::coroutine_handle<Promise> current) noexcept {
+        state = stop_state_of(current);
+        return false;
+    }
+
+    stop_state *await_resume() const noexcept { return state; }
+
+    stop_state *state = nullptr;
+};
+
+} // namespace taskio::detail
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <coroutine>
+#include <cstdint>
+
+namespace taskio::detail {
+
+/**
+ * @brief The completion token of an I/O request, its address is the
+ * user_data of the sqe. It lives inside the awaiter that submitted the
+ * request, so it must stay alive until the final cqe is reaped.
+ */
+struct task_info {
+    using completion_handler =
+        void (*)(task_info *info, int32_t result, uint32_t flags) noexcept;
+
+    // Called for every cqe of the request if set, otherwise the result is
+    // stored and `handle` is posted to the ready queue
+    completion_handler on_complete = nullptr;
+
+    std::coroutine_handle<> handle;
+
+    // cqe->res, the byte count or -errno
+    int32_t result = 0;
+
+    // cqe->flags
+    uint32_t flags = 0;
+};
+
+} // namespace taskio::detail
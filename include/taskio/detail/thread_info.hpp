@@ -11,10 +11,22 @@ struct io_context;
 namespace taskio::detail {
 
 struct worker_meta;
+class frame_pool;
+class log_ring;
+struct worker_metrics;
+class trace_ring;
 
 struct alignas(config::cache_line_size) thread_info {
     io_context *ctx = nullptr;
     worker_meta *worker = nullptr;
+    // the coroutine frames of this thread, adopted on first use
+    frame_pool *frames = nullptr;
+    // the async log records of this thread, registered on first use
+    log_ring *log = nullptr;
+    // the counters of the worker, if config::is_counter_metrics
+    worker_metrics *metrics = nullptr;
+    // the trace events of this thread, registered on first use
+    trace_ring *trace = nullptr;
 
     config::ctx_id_t ctx_id = static_cast<config::ctx_id_t>(-1);
 };
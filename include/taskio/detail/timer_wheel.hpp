@@ -0,0 +1,117 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+#include <linux/time_types.h>
+
+namespace taskio::detail {
+
+/**
+ * @brief A timer armed in a timer_wheel, it lives in the frame of the
+ * coroutine that arms it
+ */
+struct timer_node {
+    using callback = void (*)(timer_node *node) noexcept;
+
+    callback on_expire = nullptr;
+    timer_node *prev = nullptr;
+    timer_node *next = nullptr;
+    // the tick to fire at
+    uint64_t expire = 0;
+    // the slot the node is linked in, level * slot_num + index
+    uint16_t slot = 0;
+    bool linked = false;
+};
+
+/**
+ * @brief A hierarchical timer wheel with a resolution of 1ms. Adding and
+ * removing a timer are O(1), timers in the upper levels are cascaded down
+ * when their slot comes up. The wheel itself never sleeps, the io_context
+ * programs the next tick returned by next_tick() as a ring timeout.
+ */
+class timer_wheel {
+  public:
+    using clock = std::chrono::steady_clock;
+
+    inline static constexpr uint32_t level_num = 4;
+    inline static constexpr uint32_t slot_bits = 6;
+    inline static constexpr uint32_t slot_num = 1U << slot_bits;
+    inline static constexpr uint64_t slot_mask = slot_num - 1;
+
+    timer_wheel() noexcept = default;
+
+    timer_wheel(const timer_wheel &) = delete;
+    timer_wheel &operator=(const timer_wheel &) = delete;
+
+    // ticks are milliseconds of the steady clock, a deadline is rounded up
+    // so that it never fires early
+    static uint64_t to_tick(clock::time_point deadline) noexcept {
+        auto ms = std::chrono::ceil<std::chrono::milliseconds>(
+            deadline.time_since_epoch()
+        );
+        return ms.count() > 0 ? ms.count() : 0;
+    }
+
+    static uint64_t now_tick() noexcept {
+        auto ms = std::chrono::floor<std::chrono::milliseconds>(
+            clock::now().time_since_epoch()
+        );
+        return ms.count();
+    }
+
+    // steady_clock is CLOCK_MONOTONIC, the clock of absolute ring timeouts
+    static __kernel_timespec to_timespec(uint64_t tick) noexcept {
+        return {
+            .tv_sec = static_cast<int64_t>(tick / 1000),
+            .tv_nsec = static_cast<long long>(tick % 1000) * 1'000'000};
+    }
+
+    /**
+     * @brief Arm `node` to fire at `node->expire`, immediately on the next
+     * advance() if it is already due
+     */
+    void add(timer_node *node) noexcept;
+
+    // no-op if the node has fired or was removed
+    void remove(timer_node *node) noexcept;
+
+    /**
+     * @brief Fire every timer due at or before `tick`
+     */
+    void advance(uint64_t tick) noexcept;
+
+    /**
+     * @brief The next tick at which advance() has work to do, either firing
+     * or cascading. UINT64_MAX if the wheel is empty.
+     */
+    [[nodiscard]]
+    uint64_t next_tick() const noexcept;
+
+    [[nodiscard]]
+    bool empty() const noexcept {
+        return timer_num == 0;
+    }
+
+    [[nodiscard]]
+    std::size_t size() const noexcept {
+        return timer_num;
+    }
+
+  private:
+    // link `node` at its expiry, no earlier than the tick `earliest`
+    void link(timer_node *node, uint64_t earliest) noexcept;
+
+    void unlink(timer_node *node) noexcept;
+
+    void cascade(uint32_t level) noexcept;
+
+  private:
+    timer_node *slots[level_num * slot_num]{};
+    // a bit is set for every non-empty slot of the level
+    uint64_t occupied[level_num]{};
+    uint64_t current = 0;
+    std::size_t timer_num = 0;
+};
+
+} // namespace taskio::detail
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include <taskio/config.hpp>
+#include <taskio/detail/thread_info.hpp>
+#include <taskio/trace.hpp>
+
+namespace taskio::detail {
+
+inline uint64_t trace_clock() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch())
+            .count());
+#endif
+}
+
+/**
+ * @brief The latest trace events of one thread, older ones are overwritten
+ */
+class trace_ring {
+  public:
+    static constexpr std::size_t capacity = config::trace_ring_size;
+    static_assert(std::has_single_bit(capacity), "capacity must be 2^n");
+
+    explicit trace_ring(uint32_t tid)
+        : events(new trace::event[capacity]), tid(tid) {}
+
+    // owning thread only
+    void record(const trace::event &event) noexcept {
+        uint64_t pos = end.load(std::memory_order_relaxed);
+        events[pos & mask] = event;
+        end.store(pos + 1, std::memory_order_release);
+    }
+
+  private:
+    friend struct trace_registry;
+
+    static constexpr std::size_t mask = capacity - 1;
+
+    const std::unique_ptr<trace::event[]> events;
+    // the number of events recorded since the ring was taken
+    std::atomic<uint64_t> end{0};
+    // written under the registry mutex
+    uint32_t tid;
+};
+
+// the ring of the current thread, see trace_registry for its lifetime
+trace_ring &register_trace_ring();
+
+/**
+ * @brief Record an event on the current thread, compiled out unless
+ * config::tracing
+ */
+inline void trace_event(trace::event_type type, const void *id,
+                        uint32_t arg = 0) noexcept {
+    if constexpr (config::tracing) {
+        trace_ring *ring = this_thread.trace;
+        if (ring == nullptr) [[unlikely]] {
+            ring = &register_trace_ring();
+        }
+        ring->record({trace_clock(), reinterpret_cast<uint64_t>(id), arg, type,
+                      this_thread.ctx_id});
+    }
+}
+
+} // namespace taskio::detail
@@ -1,11 +1,27 @@
 #pragma once
 
-#include <taskio/detail/co_spsc.hpp>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <vector>
+
+#include <liburing.h>
+
+#include <taskio/context_options.hpp>
+#include <taskio/detail/buffer_arena.hpp>
+#include <taskio/detail/buffer_pool.hpp>
+#include <taskio/detail/co_deque.hpp>
+#include <taskio/detail/co_mpsc.hpp>
+#include <taskio/detail/metrics.hpp>
+#include <taskio/detail/ready_queue.hpp>
+#include <taskio/detail/stop_state.hpp>
+#include <taskio/detail/task_info.hpp>
+#include <taskio/detail/timer_wheel.hpp>
 
 namespace taskio::detail {
 
 struct worker_meta {
-    void init() noexcept;
+    void init(const context_options &options) noexcept;
 
     void deinit() noexcept;
 
@@ -13,16 +29,260 @@ struct worker_meta {
 
     void work_once() noexcept;
 
+    // the task stays on this worker
     void post_task(std::coroutine_handle<> handle) noexcept;
 
-    auto task_num() noexcept { return ready_task.task_num(); }
+    /**
+     * @brief Run `handle` next, for a task woken up by the running one while
+     * its frame is still hot in cache. The task it displaces from the LIFO
+     * slot goes to the ready queue.
+     */
+    void post_next(std::coroutine_handle<> handle) noexcept;
+
+    // the task may run on another worker, see config::work_stealing
+    void post_stealable(std::coroutine_handle<> handle) noexcept;
+
+    std::size_t task_num() const noexcept {
+        return ready_task.task_num() + stealable.size() + bool(next_task);
+    }
+
+    [[nodiscard]]
+    uint32_t stealable_num() const noexcept {
+        return stealable.size();
+    }
+
+    /**
+     * @brief Move up to half of the stealable tasks of `victim` to this
+     * worker, thread-safe for the victim
+     * @return the number of tasks stolen
+     */
+    uint32_t steal_from(worker_meta &victim) noexcept;
+
+    /**
+     * @brief Thread-safe, hand `handle` over to this worker and wake it up
+     * if it is blocked in the kernel. Never waits for the worker, a full
+     * injection queue spills into an overflow list.
+     */
+    void inject(std::coroutine_handle<> handle, bool is_stealable) noexcept;
+
+    /**
+     * @brief Thread-safe, wake the worker up if it is blocked in the kernel
+     * @return false if it wasn't
+     */
+    bool try_wake() noexcept;
+
+    /**
+     * @brief Move the injected tasks to the ready queue
+     * @return the number of tasks moved
+     */
+    uint32_t drain_injected() noexcept;
+
+    [[nodiscard]]
+    bool has_injected() const noexcept {
+        return !injected.empty()
+            || has_overflow.load(std::memory_order_seq_cst);
+    }
+
+    /**
+     * @brief Thread-safe, run the callback of `node` on this worker. For a
+     * stop requested on another thread.
+     */
+    void post_stop(stop_callback_node *node) noexcept;
+
+    // drop `node` if its callback is still pending, on the owning thread
+    void cancel_stop(stop_callback_node *node) noexcept;
+
+    /**
+     * @brief Run the stop callbacks handed over by other threads
+     */
+    void run_stops() noexcept {
+        if (has_stops()) [[unlikely]] {
+            run_stops_slow();
+        }
+    }
+
+    [[nodiscard]]
+    bool has_stops() const noexcept {
+        return pending_stops.load(std::memory_order_acquire);
+    }
+
+    /**
+     * @brief Thread-safe, wake the worker up through its eventfd
+     */
+    void notify() noexcept;
+
+    /**
+     * @brief Get a free sqe, flushing the submission queue if it is full.
+     * Every sqe handed out counts as one request to reap, so it must produce
+     * at least one cqe.
+     */
+    io_uring_sqe *get_free_sqe() noexcept;
+
+    /**
+     * @brief Submit the pending sqes and reap the ready cqes without blocking
+     */
+    void poll_completion() noexcept;
+
+    /**
+     * @brief Submit the pending sqes and block until at least one cqe arrives
+     * or another thread wakes the worker up. Doesn't block if tasks were
+     * injected meanwhile.
+     * @param timeout return after that long anyway, 0 for no limit
+     */
+    void wait_completion(std::chrono::milliseconds timeout = {}) noexcept;
+
+    /**
+     * @brief Fire the timers that are due, their tasks become ready
+     */
+    void advance_timers() noexcept;
+
+    /**
+     * @brief Program the nearest timer expiry as the one ring timeout, or
+     * remove that timeout once no timer is left. Called before blocking.
+     */
+    void sync_ring_timeout() noexcept;
+
+    // for the registration calls, only valid on the owning thread
+    io_uring &uring() noexcept { return ring; }
+
+    timer_wheel &timers() noexcept { return wheel; }
+
+    buffer_pool &provided_buffers() noexcept { return buffers; }
+
+    buffer_arena &fixed_buffers() noexcept { return arena; }
+
+    [[nodiscard]]
+    bool has_io_in_flight() const noexcept {
+        return requests_to_reap != 0;
+    }
+
+    // thread-safe, a task was spawned onto this worker
+    void count_spawned() noexcept {
+        if constexpr (config::is_counter_metrics) {
+            metrics.spawned.add_shared();
+        }
+    }
+
+    void count_loop() noexcept {
+        if constexpr (config::is_counter_metrics) {
+            metrics.loop_iterations.add();
+        }
+    }
+
+    // the worker runs out of work and spins or blocks until end_idle()
+    void begin_idle() noexcept {
+        if constexpr (config::is_counter_metrics) {
+            idle_since = metrics_now();
+            metrics.busy_ns.add(idle_since - metrics.active_since);
+        }
+    }
+
+    void end_idle() noexcept {
+        if constexpr (config::is_counter_metrics) {
+            metrics.active_since = metrics_now();
+            metrics.idle_ns.add(metrics.active_since - idle_since);
+        }
+    }
+
+    // thread-safe
+    void read_metrics(context_metrics &out) const noexcept {
+        if constexpr (config::is_counter_metrics) {
+            metrics.read(out);
+        }
+    }
 
     worker_meta() = default;
 
+    // the eventfd is closed here rather than in deinit(), so that a late
+    // notify() never writes to a closed or reused descriptor
+    ~worker_meta();
+
   private:
+    // post a task that became ready at `ready_at`, see ready_stamp()
+    void post_stamped(std::coroutine_handle<> handle, uint64_t ready_at,
+                      bool is_stealable) noexcept;
+
+    // an sqe that is not counted as a request to reap
+    io_uring_sqe *get_sqe() noexcept;
+
+    void arm_wakeup() noexcept;
+
+    // wake up from the ring of the calling worker or else the eventfd
+    void wake() noexcept;
+
+    void reap_completion() noexcept;
+
+    void run_stops_slow() noexcept;
+
+    void handle_cq_entry(const io_uring_cqe *cqe) noexcept;
+
+    static void
+    on_ring_timeout(task_info *info, int32_t result, uint32_t flags) noexcept;
+
+  private:
+    enum class timeout_state : uint8_t { idle, armed, removing };
+
+    io_uring ring;
+    // a kernel thread submits, no syscall needed unless it sleeps
+    bool sq_polled = false;
+
+    buffer_pool buffers;
+
+    buffer_arena arena;
+
+    timer_wheel wheel;
+    // the ring timeout waking the thread up for the nearest timer
+    task_info timeout_info;
+    __kernel_timespec timeout_spec{};
+    uint64_t timeout_tick = 0;
+    timeout_state timeout = timeout_state::idle;
+
     // the number of I/O tasks running in the io_uring
     uint32_t requests_to_reap = 0;
-    spsc<config::cur_t, config::spsc_capacity, safety::unsafe> ready_task;
+    ready_queue<config::ready_segment_size> ready_task;
+    // the LIFO slot and the tasks run from it in a row
+    std::coroutine_handle<> next_task;
+    uint32_t lifo_streak = 0;
+    // when the tasks became ready, with config::is_latency_metrics
+    uint64_t next_task_at = 0;
+    uint64_t scheduled_at = 0;
+    // no room taken when stealing is off
+    steal_deque<config::work_stealing ? config::steal_capacity : 1> stealable;
+
+    // the wakeups posted by other threads are not requests to reap: the
+    // eventfd read stays armed and msg_ring cqes carry `wake_info`
+    task_info wake_info;
+    task_info wakeup_read_info;
+    int wakeup_fd = -1;
+    uint64_t wakeup_value = 0;
+
+    // set while blocked in the kernel, injectors wake the worker if set
+    alignas(config::cache_line_size) std::atomic<bool> sleeping{false};
+    struct injected_task {
+        std::coroutine_handle<> handle;
+        // stamped by the injecting thread, the wait for the drain counts
+        uint64_t ready_at;
+        bool is_stealable;
+    };
+
+    mpsc<injected_task, uint32_t, config::mpsc_capacity> injected;
+    // the tasks injected while `injected` was full, the producers keep
+    // spilling here until the worker drains it so that each producer's
+    // tasks stay in order
+    std::atomic<bool> has_overflow{false};
+    std::mutex overflow_mtx;
+    std::vector<injected_task> overflow;
+    // swapped with `overflow` by the drain, keeps its capacity
+    std::vector<injected_task> overflow_spare;
+
+    // the stop callbacks handed over by other threads
+    std::atomic<bool> pending_stops{false};
+    std::mutex stops_mtx;
+    stop_callback_node *stops_head = nullptr;
+
+    // read by snapshots from other threads, untouched unless enabled
+    worker_metrics metrics;
+    uint64_t idle_since = 0;
 };
 
 } // namespace taskio::detail
@@ -1,50 +1,291 @@
 #pragma once
 
+#include <concepts>
 #include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <iterator>
 #include <memory>
+#include <ranges>
+#include <type_traits>
 #include <utility>
 
+#include <taskio/detail/frame_allocator.hpp>
+
 namespace taskio {
 
-template<typename T, typename allocator = std::allocator<char>>
-struct generator {
-    struct promise_type {
-        generator get_return_object() noexcept { return generator{*this}; }
+template<typename T, typename allocator>
+struct generator;
 
-        std::suspend_always initial_suspend() noexcept { return {}; }
+/**
+ * @brief `co_yield elements_of(range)` yields every element of `range`. A
+ * nested generator is resumed directly by the consumer, so each element
+ * costs one resume whatever the depth of the nesting.
+ */
+template<std::ranges::range R>
+struct elements_of {
+    [[no_unique_address]] R range;
+};
 
-        std::suspend_always final_suspend() noexcept { return {}; }
+template<typename R>
+elements_of(R &&) -> elements_of<R &&>;
 
-        void return_void() noexcept {}
+namespace detail {
+    /**
+     * @brief The part of the promise shared by the generators of any
+     * allocator. The outermost generator keeps the yielded value and the
+     * innermost active generator, which is the one the consumer resumes.
+     */
+    template<typename T>
+    struct generator_promise_base {
+        struct final_awaiter {
+            static constexpr bool await_ready() noexcept { return false; }
+
+            template<typename Promise>
+            std::coroutine_handle<>
+            await_suspend(std::coroutine_handle<Promise> current) noexcept {
+                generator_promise_base &self = current.promise();
+                if (self.parent) {
+                    self.root->leaf = self.parent;
+                    return self.parent;
+                }
+                return std::noop_coroutine();
+            }
+
+            // Won't be resumed anyway
+            constexpr void await_resume() const noexcept {}
+        };
 
-        std::suspend_always yield_value(const T &val) noexcept {
-            value = std::addressof(val);
+        /**
+         * @brief Lends a yielded lvalue to the consumer, which stays valid
+         * while the generator is suspended. It is copied only once the
+         * consumer takes it, so that moving from it leaves the producer's
+         * object alone.
+         */
+        struct copy_awaiter {
+            copy_awaiter(const T &ref, generator_promise_base *root) noexcept
+                : ref(ref), root(root) {}
+
+            copy_awaiter(const copy_awaiter &) = delete;
+            copy_awaiter &operator=(const copy_awaiter &) = delete;
+
+            ~copy_awaiter() {
+                if (is_copied) {
+                    std::destroy_at(std::addressof(copy));
+                }
+            }
+
+            static constexpr bool await_ready() noexcept { return false; }
+
+            void await_suspend(std::coroutine_handle<>) noexcept {
+                root->value = nullptr;
+                root->lent = this;
+            }
+
+            constexpr void await_resume() const noexcept {}
+
+            T *own() noexcept(std::is_nothrow_copy_constructible_v<T>) {
+                if (!is_copied) {
+                    std::construct_at(std::addressof(copy), ref);
+                    is_copied = true;
+                }
+                return std::addressof(copy);
+            }
+
+            const T &ref;
+            generator_promise_base *root;
+            union {
+                T copy;
+            };
+            bool is_copied = false;
+        };
+
+        /**
+         * @brief Runs a nested generator, the consumer resumes it directly
+         * until it finishes, then it resumes the generator that yielded it
+         */
+        template<typename Gen>
+        struct nested_awaiter {
+            static constexpr bool await_ready() noexcept { return false; }
+
+            std::coroutine_handle<>
+            await_suspend(std::coroutine_handle<> current) noexcept {
+                if (!gen.coro) {
+                    return current;
+                }
+                generator_promise_base &child = gen.coro.promise();
+                child.root = root;
+                child.parent = current;
+                root->leaf = gen.coro;
+                return gen.coro;
+            }
+
+            void await_resume() {
+                if (gen.coro) {
+                    gen.coro.promise().rethrow_if_exception();
+                }
+            }
+
+            Gen gen;
+            generator_promise_base *root;
+        };
+
+        std::suspend_always initial_suspend() noexcept { return {}; }
+
+        final_awaiter final_suspend() noexcept { return {}; }
+
+        std::suspend_always yield_value(T &&val) noexcept {
+            root->value = std::addressof(val);
             return {};
         }
 
+        copy_awaiter yield_value(const T &val
+        ) noexcept(std::is_nothrow_copy_constructible_v<T>)
+            requires std::copy_constructible<T>
+        {
+            return {val, root};
+        }
+
+        template<typename Alloc>
+        nested_awaiter<generator<T, Alloc>>
+        yield_value(elements_of<generator<T, Alloc> &&> nested) noexcept {
+            return {std::move(nested.range), root};
+        }
+
+        template<typename Alloc>
+        nested_awaiter<generator<T, Alloc>>
+        yield_value(elements_of<generator<T, Alloc>> nested) noexcept {
+            return {std::move(nested.range), root};
+        }
+
+        // any other range is walked by a nested generator
+        template<std::ranges::input_range R>
+            requires std::convertible_to<std::ranges::range_reference_t<R>, T>
+        auto yield_value(elements_of<R> nested) {
+            return yield_value(
+                elements_of{flatten<R>(std::forward<R>(nested.range))}
+            );
+        }
+
+        void return_void() noexcept {}
+
         void unhandled_exception() noexcept {
             exception = std::current_exception();
         }
 
         void rethrow_if_exception() {
             if (exception) {
-                std::rethrow_exception(exception);
+                std::rethrow_exception(std::exchange(exception, nullptr));
             }
         }
 
+        // a generator is resumed synchronously by its consumer, it can't
+        // suspend on anything else: use async_generator to await inside
         template<typename Ty>
-        Ty &&await_transform(Ty &&awaitable) {
-            return std::forward<Ty>(awaitable);
+        void await_transform(Ty &&) = delete;
+
+        // the value the consumer takes, only meaningful on the outermost
+        // generator
+        T &current() noexcept(std::is_nothrow_copy_constructible_v<T>) {
+            if constexpr (std::copy_constructible<T>) {
+                if (value == nullptr) {
+                    value = lent->own();
+                }
+            }
+            return *value;
+        }
+
+        // the value without taking it, a lent lvalue isn't copied
+        const T &peek() const noexcept {
+            if constexpr (std::copy_constructible<T>) {
+                if (value == nullptr) {
+                    return lent->ref;
+                }
+            }
+            return *value;
         }
 
+        // a yielded rvalue or the copy of a lent lvalue, nullptr while an
+        // lvalue is lent and not copied yet
+        T *value = nullptr;
+        copy_awaiter *lent = nullptr;
+        generator_promise_base *root = this;
+        // the outermost generator: the generator the consumer resumes
+        std::coroutine_handle<> leaf;
+        // a nested generator: the generator that yielded it
+        std::coroutine_handle<> parent;
         std::exception_ptr exception;
-        const T *value;
+
+      private:
+        template<typename R>
+        static generator<T, std::allocator<char>> flatten(R range) {
+            for (auto &&elem : range) {
+                co_yield static_cast<T>(std::forward<decltype(elem)>(elem));
+            }
+        }
+    };
+} // namespace detail
+
+/**
+ * @brief A synchronous generator whose frame is allocated through
+ * `allocator`. A stateful allocator is passed as the leading
+ * `std::allocator_arg, alloc` parameters of the coroutine, like
+ * std::generator. Dereferencing an iterator gives a `T &&`, so the yielded
+ * values can be moved out. A yielded lvalue is only copied by that
+ * dereference, `it->` reads it in place.
+ */
+template<typename T, typename allocator = std::allocator<char>>
+struct generator : std::ranges::view_interface<generator<T, allocator>> {
+    template<typename, typename>
+    friend struct generator;
+
+    friend struct detail::generator_promise_base<T>;
+
+    struct promise_type : detail::generator_promise_base<T> {
+        using frame_alloc = detail::frame_allocator<allocator>;
+
+        static void *operator new(std::size_t size)
+            requires std::default_initializable<allocator>
+        {
+            return frame_alloc::allocate(allocator{}, size);
+        }
+
+        template<typename Alloc, typename... Args>
+            requires std::convertible_to<const Alloc &, allocator>
+        static void *operator new(
+            std::size_t size,
+            std::allocator_arg_t,
+            const Alloc &alloc,
+            const Args &...
+        ) {
+            return frame_alloc::allocate(allocator(alloc), size);
+        }
+
+        // member function generators get the object as the first argument
+        template<typename This, typename Alloc, typename... Args>
+            requires std::convertible_to<const Alloc &, allocator>
+        static void *operator new(
+            std::size_t size,
+            const This &,
+            std::allocator_arg_t,
+            const Alloc &alloc,
+            const Args &...
+        ) {
+            return frame_alloc::allocate(allocator(alloc), size);
+        }
+
+        static void operator delete(void *ptr, std::size_t size) noexcept {
+            frame_alloc::deallocate(ptr, size);
+        }
+
+        generator get_return_object() noexcept { return generator{*this}; }
     };
 
     struct iterator {
-        using value_type = T;
-        using point = const T *;
-        using refererce = const T &;
+        using iterator_concept = std::input_iterator_tag;
+        using difference_type = std::ptrdiff_t;
+        using value_type = std::remove_cvref_t<T>;
+        using reference = T &&;
 
         iterator() = default;
 
@@ -52,37 +293,32 @@ struct generator {
             : coro(handle) {}
 
         iterator &operator++() {
-            coro.resume();
+            coro.promise().leaf.resume();
             if (coro.done()) {
-                std::exchange(coro, nullptr).promise().rethrow_if_exception();
+                coro.promise().rethrow_if_exception();
             }
             return *this;
         }
 
         void operator++(int) { ++(*this); }
 
+        // a yielded lvalue is copied on the first dereference
         [[nodiscard]]
-        bool
-        operator==(const iterator &rhs) const noexcept {
-            return coro == rhs.coro;
-        }
-
-        [[nodiscard]]
-        bool
-        operator!=(const iterator &rhs) const noexcept {
-            return !(*this == rhs); // NOLINT
+        reference
+        operator*() const noexcept(std::is_nothrow_copy_constructible_v<T>) {
+            return static_cast<reference>(coro.promise().current());
         }
 
+        // reads the value in place, a yielded lvalue isn't copied
         [[nodiscard]]
-        refererce
-        operator*() const noexcept {
-            return *coro.promise().value;
+        const T *operator->() const noexcept {
+            return std::addressof(coro.promise().peek());
         }
 
         [[nodiscard]]
-        point
-        operator->() const noexcept {
-            return coro.promise().valuel;
+        friend bool
+        operator==(const iterator &it, std::default_sentinel_t) noexcept {
+            return !it.coro || it.coro.done();
         }
 
       private:
@@ -92,10 +328,9 @@ struct generator {
     [[nodiscard]]
     iterator begin() {
         if (coro) {
-            coro.resume();
+            coro.promise().leaf.resume();
             if (coro.done()) {
                 coro.promise().rethrow_if_exception();
-                return {}; // as end iterator
             }
         }
 
@@ -103,20 +338,27 @@ struct generator {
     }
 
     [[nodiscard]]
-    iterator end() noexcept {
-        return {};
+    std::default_sentinel_t end() const noexcept {
+        return std::default_sentinel;
     }
 
     generator() = default;
 
     explicit generator(promise_type &promise) noexcept
-        : coro(std::coroutine_handle<promise_type>::from_promise(promise)) {}
+        : coro(std::coroutine_handle<promise_type>::from_promise(promise)) {
+        promise.leaf = coro;
+    }
 
     generator(generator &&rhs) noexcept
         : coro(std::exchange(rhs.coro, nullptr)) {}
 
     generator &operator=(generator &&rhs) noexcept {
-        coro = std::exchange(rhs.coro, nullptr);
+        if (this != std::addressof(rhs)) {
+            if (coro) {
+                coro.destroy();
+            }
+            coro = std::exchange(rhs.coro, nullptr);
+        }
         return *this;
     }
 
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <utility>
+
+#include <taskio/detail/buffer_pool.hpp>
+
+namespace taskio::io {
+
+/**
+ * @brief A provided buffer borrowed from the pool of the io_context, it goes
+ * back to the kernel when destroyed. Must be destroyed on the thread of
+ * that io_context.
+ */
+class buffer {
+    friend class detail::buffer_pool;
+
+  public:
+    buffer() noexcept = default;
+
+    buffer(const buffer &) = delete;
+    buffer &operator=(const buffer &) = delete;
+
+    buffer(buffer &&other) noexcept
+        : pool(std::exchange(other.pool, nullptr))
+        , ptr(other.ptr)
+        , len(other.len)
+        , bid(other.bid) {}
+
+    buffer &operator=(buffer &&other) noexcept {
+        if (this != std::addressof(other)) [[likely]] {
+            release();
+            pool = std::exchange(other.pool, nullptr);
+            ptr = other.ptr;
+            len = other.len;
+            bid = other.bid;
+        }
+        return *this;
+    }
+
+    ~buffer() { release(); }
+
+    // the received bytes
+    [[nodiscard]]
+    std::span<char> data() const noexcept {
+        return {ptr, len};
+    }
+
+    [[nodiscard]]
+    std::size_t size() const noexcept {
+        return len;
+    }
+
+    explicit operator bool() const noexcept { return pool != nullptr; }
+
+    /**
+     * @brief Give the buffer back before destruction
+     */
+    void release() noexcept {
+        if (pool != nullptr) {
+            std::exchange(pool, nullptr)->recycle(bid);
+        }
+    }
+
+  private:
+    buffer(detail::buffer_pool *pool, char *ptr, uint32_t len, uint16_t bid)
+        noexcept
+        : pool(pool), ptr(ptr), len(len), bid(bid) {}
+
+    detail::buffer_pool *pool = nullptr;
+    char *ptr = nullptr;
+    uint32_t len = 0;
+    uint16_t bid = 0;
+};
+
+} // namespace taskio::io
@@ -0,0 +1,270 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+
+#include <fcntl.h>
+#include <sys/uio.h>
+
+#include <taskio/concept/awaitable.hpp>
+#include <taskio/detail/lazy_awaiter.hpp>
+#include <taskio/io/fixed_buffer.hpp>
+
+namespace taskio {
+
+namespace detail {
+    struct lazy_read : lazy_awaiter<lazy_read> {
+        lazy_read(int fd, std::span<char> buf, uint64_t offset) noexcept
+            : fd(fd), buf(buf), offset(offset) {}
+
+        void prep(io_uring_sqe *sqe) noexcept {
+            io_uring_prep_read(sqe, fd, buf.data(), buf.size(), offset);
+        }
+
+      private:
+        int fd;
+        std::span<char> buf;
+        uint64_t offset;
+    };
+
+    struct lazy_write : lazy_awaiter<lazy_write> {
+        lazy_write(int fd, std::span<const char> buf, uint64_t offset) noexcept
+            : fd(fd), buf(buf), offset(offset) {}
+
+        void prep(io_uring_sqe *sqe) noexcept {
+            io_uring_prep_write(sqe, fd, buf.data(), buf.size(), offset);
+        }
+
+      private:
+        int fd;
+        std::span<const char> buf;
+        uint64_t offset;
+    };
+
+    struct lazy_read_fixed : lazy_awaiter<lazy_read_fixed> {
+        lazy_read_fixed(
+            int fd, std::span<char> buf, uint16_t buf_index, uint64_t offset
+        ) noexcept
+            : fd(fd), buf_index(buf_index), buf(buf), offset(offset) {}
+
+        void prep(io_uring_sqe *sqe) noexcept {
+            io_uring_prep_read_fixed(
+                sqe, fd, buf.data(), buf.size(), offset, buf_index
+            );
+        }
+
+      private:
+        int fd;
+        uint16_t buf_index;
+        std::span<char> buf;
+        uint64_t offset;
+    };
+
+    struct lazy_write_fixed : lazy_awaiter<lazy_write_fixed> {
+        lazy_write_fixed(
+            int fd,
+            std::span<const char> buf,
+            uint16_t buf_index,
+            uint64_t offset
+        ) noexcept
+            : fd(fd), buf_index(buf_index), buf(buf), offset(offset) {}
+
+        void prep(io_uring_sqe *sqe) noexcept {
+            io_uring_prep_write_fixed(
+                sqe, fd, buf.data(), buf.size(), offset, buf_index
+            );
+        }
+
+      private:
+        int fd;
+        uint16_t buf_index;
+        std::span<const char> buf;
+        uint64_t offset;
+    };
+
+    struct lazy_readv : lazy_awaiter<lazy_readv> {
+        lazy_readv(
+            int fd, std::span<const iovec> iovecs, uint64_t offset
+        ) noexcept
+            : fd(fd), iovecs(iovecs), offset(offset) {}
+
+        void prep(io_uring_sqe *sqe) noexcept {
+            io_uring_prep_readv(
+                sqe, fd, iovecs.data(), iovecs.size(), offset
+            );
+        }
+
+      private:
+        int fd;
+        std::span<const iovec> iovecs;
+        uint64_t offset;
+    };
+
+    struct lazy_writev : lazy_awaiter<lazy_writev> {
+        lazy_writev(
+            int fd, std::span<const iovec> iovecs, uint64_t offset
+        ) noexcept
+            : fd(fd), iovecs(iovecs), offset(offset) {}
+
+        void prep(io_uring_sqe *sqe) noexcept {
+            io_uring_prep_writev(
+                sqe, fd, iovecs.data(), iovecs.size(), offset
+            );
+        }
+
+      private:
+        int fd;
+        std::span<const iovec> iovecs;
+        uint64_t offset;
+    };
+
+    struct lazy_fsync : lazy_awaiter<lazy_fsync> {
+        lazy_fsync(int fd, uint32_t fsync_flags) noexcept
+            : fd(fd), fsync_flags(fsync_flags) {}
+
+        void prep(io_uring_sqe *sqe) noexcept {
+            io_uring_prep_fsync(sqe, fd, fsync_flags);
+        }
+
+      private:
+        int fd;
+        uint32_t fsync_flags;
+    };
+
+    struct lazy_openat : lazy_awaiter<lazy_openat> {
+        lazy_openat(int dfd, const char *path, int flags, mode_t mode) noexcept
+            : dfd(dfd), path(path), flags(flags), mode(mode) {}
+
+        void prep(io_uring_sqe *sqe) noexcept {
+            io_uring_prep_openat(sqe, dfd, path, flags, mode);
+        }
+
+      private:
+        int dfd;
+        const char *path;
+        int flags;
+        mode_t mode;
+    };
+
+    struct lazy_close : lazy_awaiter<lazy_close> {
+        explicit lazy_close(int fd) noexcept : fd(fd) {}
+
+        void prep(io_uring_sqe *sqe) noexcept { io_uring_prep_close(sqe, fd); }
+
+      private:
+        int fd;
+    };
+
+    static_assert(concepts::Awaitable<lazy_read>);
+    static_assert(concepts::Awaitable<lazy_write>);
+    static_assert(concepts::Awaitable<lazy_read_fixed>);
+    static_assert(concepts::Awaitable<lazy_write_fixed>);
+    static_assert(concepts::Awaitable<lazy_readv>);
+    static_assert(concepts::Awaitable<lazy_writev>);
+    static_assert(concepts::Awaitable<lazy_fsync>);
+    static_assert(concepts::Awaitable<lazy_openat>);
+    static_assert(concepts::Awaitable<lazy_close>);
+} // namespace detail
+
+/**
+ * The file operations below must be awaited inside a coroutine running on an
+ * io_context. Each of them resumes with the cqe result: the byte count (or
+ * the new fd for openat) on success, -errno on failure.
+ * An offset of -1 means the current file position.
+ */
+namespace io {
+    [[nodiscard]]
+    inline detail::lazy_read
+    read(int fd, std::span<char> buf, uint64_t offset = -1) noexcept {
+        return {fd, buf, offset};
+    }
+
+    [[nodiscard]]
+    inline detail::lazy_write
+    write(int fd, std::span<const char> buf, uint64_t offset = -1) noexcept {
+        return {fd, buf, offset};
+    }
+
+    /**
+     * @brief Take a registered buffer from the arena reserved by
+     * io_context::reserve_fixed_buffers(), empty if none is free
+     */
+    [[nodiscard]]
+    inline fixed_buffer acquire_fixed_buffer() noexcept {
+        return detail::this_thread.worker->fixed_buffers().acquire();
+    }
+
+    /**
+     * @param buf must lie inside the registered buffer `buf_index`
+     */
+    [[nodiscard]]
+    inline detail::lazy_read_fixed read_fixed(
+        int fd, std::span<char> buf, uint16_t buf_index, uint64_t offset = -1
+    ) noexcept {
+        return {fd, buf, buf_index, offset};
+    }
+
+    [[nodiscard]]
+    inline detail::lazy_read_fixed
+    read_fixed(int fd, fixed_buffer &buf, uint64_t offset = -1) noexcept {
+        return {fd, buf.data(), buf.index(), offset};
+    }
+
+    /**
+     * @param buf must lie inside the registered buffer `buf_index`
+     */
+    [[nodiscard]]
+    inline detail::lazy_write_fixed write_fixed(
+        int fd,
+        std::span<const char> buf,
+        uint16_t buf_index,
+        uint64_t offset = -1
+    ) noexcept {
+        return {fd, buf, buf_index, offset};
+    }
+
+    [[nodiscard]]
+    inline detail::lazy_write_fixed write_fixed(
+        int fd, const fixed_buffer &buf, uint64_t offset = -1
+    ) noexcept {
+        return {fd, buf.data(), buf.index(), offset};
+    }
+
+    [[nodiscard]]
+    inline detail::lazy_readv readv(
+        int fd, std::span<const iovec> iovecs, uint64_t offset = -1
+    ) noexcept {
+        return {fd, iovecs, offset};
+    }
+
+    [[nodiscard]]
+    inline detail::lazy_writev writev(
+        int fd, std::span<const iovec> iovecs, uint64_t offset = -1
+    ) noexcept {
+        return {fd, iovecs, offset};
+    }
+
+    /**
+     * @param fsync_flags 0 or IORING_FSYNC_DATASYNC
+     */
+    [[nodiscard]]
+    inline detail::lazy_fsync fsync(int fd, uint32_t fsync_flags = 0) noexcept {
+        return {fd, fsync_flags};
+    }
+
+    /**
+     * @param path must stay valid until the request completes
+     */
+    [[nodiscard]]
+    inline detail::lazy_openat
+    openat(int dfd, const char *path, int flags, mode_t mode = 0) noexcept {
+        return {dfd, path, flags, mode};
+    }
+
+    [[nodiscard]]
+    inline detail::lazy_close close(int fd) noexcept {
+        return detail::lazy_close{fd};
+    }
+} // namespace io
+
+} // namespace taskio
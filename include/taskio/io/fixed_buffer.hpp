@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <utility>
+
+#include <taskio/detail/buffer_arena.hpp>
+
+namespace taskio::io {
+
+/**
+ * @brief A registered buffer taken from the arena of the io_context, it goes
+ * back to the arena when destroyed. Must be destroyed on the thread of that
+ * io_context, and not before the requests using it have completed.
+ */
+class fixed_buffer {
+    friend class detail::buffer_arena;
+
+  public:
+    fixed_buffer() noexcept = default;
+
+    fixed_buffer(const fixed_buffer &) = delete;
+    fixed_buffer &operator=(const fixed_buffer &) = delete;
+
+    fixed_buffer(fixed_buffer &&other) noexcept
+        : arena(std::exchange(other.arena, nullptr))
+        , ptr(other.ptr)
+        , len(other.len)
+        , buf_index(other.buf_index) {}
+
+    fixed_buffer &operator=(fixed_buffer &&other) noexcept {
+        if (this != std::addressof(other)) [[likely]] {
+            release();
+            arena = std::exchange(other.arena, nullptr);
+            ptr = other.ptr;
+            len = other.len;
+            buf_index = other.buf_index;
+        }
+        return *this;
+    }
+
+    ~fixed_buffer() { release(); }
+
+    [[nodiscard]]
+    std::span<char> data() const noexcept {
+        return {ptr, len};
+    }
+
+    [[nodiscard]]
+    std::size_t size() const noexcept {
+        return len;
+    }
+
+    // the index of the registered buffer
+    [[nodiscard]]
+    uint16_t index() const noexcept {
+        return buf_index;
+    }
+
+    explicit operator bool() const noexcept { return arena != nullptr; }
+
+    void release() noexcept {
+        if (arena != nullptr) {
+            std::exchange(arena, nullptr)->release(buf_index);
+        }
+    }
+
+  private:
+    fixed_buffer(
+        detail::buffer_arena *arena, char *ptr, uint32_t len, uint16_t index
+    ) noexcept
+        : arena(arena), ptr(ptr), len(len), buf_index(index) {}
+
+    detail::buffer_arena *arena = nullptr;
+    char *ptr = nullptr;
+    uint32_t len = 0;
+    uint16_t buf_index = 0;
+};
+
+} // namespace taskio::io
@@ -0,0 +1,410 @@
+#pragma once
+
+#include <cerrno>
+#include <cstdint>
+#include <span>
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <taskio/concept/awaitable.hpp>
+#include <taskio/detail/lazy_awaiter.hpp>
+#include <taskio/detail/multishot.hpp>
+#include <taskio/io/buffer.hpp>
+#include <taskio/io/fixed_buffer.hpp>
+
+namespace taskio {
+
+namespace io {
+    /**
+     * @brief The completion of a recv that selects a provided buffer
+     */
+    struct recv_result {
+        // the byte count, 0 on EOF, -errno on failure
+        int32_t result;
+        uint32_t flags;
+        // the received bytes, empty if nothing was received
+        buffer buf;
+
+        // whether the kernel terminated the multishot request
+        [[nodiscard]]
+        bool is_last() const noexcept {
+            return !(flags & IORING_CQE_F_MORE);
+        }
+    };
+} // namespace io
+
+namespace detail {
+    struct lazy_accept : lazy_awaiter<lazy_accept> {
+        lazy_accept(
+            int fd, sockaddr *addr, socklen_t *addrlen, int flags
+        ) noexcept
+            : fd(fd), flags(flags), addr(addr), addrlen(addrlen) {}
+
+        void prep(io_uring_sqe *sqe) noexcept {
+            io_uring_prep_accept(sqe, fd, addr, addrlen, flags);
+        }
+
+      private:
+        int fd;
+        int flags;
+        sockaddr *addr;
+        socklen_t *addrlen;
+    };
+
+    struct lazy_connect : lazy_awaiter<lazy_connect> {
+        lazy_connect(int fd, const sockaddr *addr, socklen_t addrlen) noexcept
+            : fd(fd), addrlen(addrlen), addr(addr) {}
+
+        void prep(io_uring_sqe *sqe) noexcept {
+            io_uring_prep_connect(sqe, fd, addr, addrlen);
+        }
+
+      private:
+        int fd;
+        socklen_t addrlen;
+        const sockaddr *addr;
+    };
+
+    struct lazy_recv : lazy_awaiter<lazy_recv> {
+        lazy_recv(int fd, std::span<char> buf, int flags) noexcept
+            : fd(fd), flags(flags), buf(buf) {}
+
+        void prep(io_uring_sqe *sqe) noexcept {
+            io_uring_prep_recv(sqe, fd, buf.data(), buf.size(), flags);
+        }
+
+      private:
+        int fd;
+        int flags;
+        std::span<char> buf;
+    };
+
+    struct lazy_send : lazy_awaiter<lazy_send> {
+        lazy_send(int fd, std::span<const char> buf, int flags) noexcept
+            : fd(fd), flags(flags), buf(buf) {}
+
+        void prep(io_uring_sqe *sqe) noexcept {
+            io_uring_prep_send(sqe, fd, buf.data(), buf.size(), flags);
+        }
+
+      private:
+        int fd;
+        int flags;
+        std::span<const char> buf;
+    };
+
+    /**
+     * @brief Zero-copy send, the kernel posts a notification cqe once it no
+     * longer references the buffer, the awaiter is resumed only then so the
+     * buffer can be reused right after.
+     */
+    struct lazy_send_zc : lazy_awaiter<lazy_send_zc> {
+        // buf_index: the registered buffer holding `buf`, -1 if none
+        lazy_send_zc(
+            int fd, std::span<const char> buf, int flags, int buf_index
+        ) noexcept
+            : fd(fd), flags(flags), buf_index(buf_index), buf(buf) {
+            this->io_info.on_complete = &lazy_send_zc::on_cqe;
+        }
+
+        void prep(io_uring_sqe *sqe) noexcept {
+            if (buf_index < 0) {
+                io_uring_prep_send_zc(
+                    sqe, fd, buf.data(), buf.size(), flags, 0
+                );
+            } else {
+                io_uring_prep_send_zc_fixed(
+                    sqe, fd, buf.data(), buf.size(), flags, 0, buf_index
+                );
+            }
+        }
+
+      private:
+        static void
+        on_cqe(task_info *info, int32_t result, uint32_t flags) noexcept {
+            // the first cqe carries the byte count, the notification follows
+            // it if the first one has IORING_CQE_F_MORE
+            if (!(flags & IORING_CQE_F_NOTIF)) {
+                info->result = result;
+                info->flags = flags;
+            }
+            if (!(flags & IORING_CQE_F_MORE)) {
+                this_thread.worker->post_task(info->handle);
+            }
+        }
+
+        int fd;
+        int flags;
+        int buf_index;
+        std::span<const char> buf;
+    };
+
+    /**
+     * @brief The buffer is taken when the cqe is reaped so the pool can grow
+     * in time, and the request is retried if the pool was empty
+     */
+    struct lazy_recv_pooled : task_info {
+        lazy_recv_pooled(int fd, int flags) noexcept
+            : fd(fd), msg_flags(flags) {
+            this->on_complete = &lazy_recv_pooled::on_cqe;
+        }
+
+        static constexpr bool await_ready() noexcept { return false; }
+
+        template<typename Promise>
+        bool await_suspend(std::coroutine_handle<Promise> current) noexcept {
+            stop_state *stop = stop_state_of(current);
+            if (stop != nullptr && stop->stop_requested()) [[unlikely]] {
+                this->result = -ECANCELED;
+                return false;
+            }
+
+            this->handle = current;
+            arm();
+            if (stop != nullptr) {
+                cancel.arm(stop, this);
+            }
+            return true;
+        }
+
+        io::recv_result await_resume() noexcept {
+            cancel.disarm();
+            return {this->result, this->flags, std::move(buf)};
+        }
+
+      private:
+        void arm() noexcept {
+            auto &pool = this_thread.worker->provided_buffers();
+            io_uring_sqe *sqe = this_thread.worker->get_free_sqe();
+            io_uring_prep_recv(
+                sqe, fd, nullptr, config::buffer_size, msg_flags
+            );
+            sqe->flags |= IOSQE_BUFFER_SELECT;
+            sqe->buf_group = pool.group_id();
+            io_uring_sqe_set_data(sqe, static_cast<task_info *>(this));
+            trace_event(trace::event_type::io_submit,
+                        static_cast<task_info *>(this), sqe->opcode);
+        }
+
+        static void
+        on_cqe(task_info *info, int32_t result, uint32_t flags) noexcept {
+            auto *self = static_cast<lazy_recv_pooled *>(info);
+            auto &pool = this_thread.worker->provided_buffers();
+            if (result == -ENOBUFS && pool.replenish()) {
+                self->arm();
+                return;
+            }
+
+            self->result = result;
+            self->flags = flags;
+            self->buf = pool.take(result, flags);
+            this_thread.worker->post_task(self->handle);
+        }
+
+        int fd;
+        int msg_flags;
+        io::buffer buf;
+        io_cancel_node cancel;
+    };
+
+    struct lazy_sendmsg : lazy_awaiter<lazy_sendmsg> {
+        lazy_sendmsg(int fd, const msghdr *msg, unsigned flags) noexcept
+            : fd(fd), flags(flags), msg(msg) {}
+
+        void prep(io_uring_sqe *sqe) noexcept {
+            io_uring_prep_sendmsg(sqe, fd, msg, flags);
+        }
+
+      private:
+        int fd;
+        unsigned flags;
+        const msghdr *msg;
+    };
+
+    struct lazy_recvmsg : lazy_awaiter<lazy_recvmsg> {
+        lazy_recvmsg(int fd, msghdr *msg, unsigned flags) noexcept
+            : fd(fd), flags(flags), msg(msg) {}
+
+        void prep(io_uring_sqe *sqe) noexcept {
+            io_uring_prep_recvmsg(sqe, fd, msg, flags);
+        }
+
+      private:
+        int fd;
+        unsigned flags;
+        msghdr *msg;
+    };
+
+    static_assert(concepts::Awaitable<lazy_accept>);
+    static_assert(concepts::Awaitable<lazy_connect>);
+    static_assert(concepts::Awaitable<lazy_recv>);
+    static_assert(concepts::Awaitable<lazy_send>);
+    static_assert(concepts::Awaitable<lazy_recv_pooled>);
+    static_assert(concepts::Awaitable<lazy_send_zc>);
+    static_assert(concepts::Awaitable<lazy_sendmsg>);
+    static_assert(concepts::Awaitable<lazy_recvmsg>);
+
+    struct multishot_accept_op {
+        using result_type = int32_t;
+
+        void prep(io_uring_sqe *sqe) noexcept {
+            io_uring_prep_multishot_accept(sqe, fd, nullptr, nullptr, flags);
+        }
+
+        static int32_t transform(cqe_entry entry) noexcept {
+            return entry.result;
+        }
+
+        static void drop(int32_t fd) noexcept {
+            if (fd >= 0) {
+                ::close(fd);
+            }
+        }
+
+        static constexpr bool rearm(cqe_entry) noexcept { return false; }
+
+        static constexpr int32_t cancelled() noexcept { return -ECANCELED; }
+
+        int fd;
+        int flags;
+    };
+
+    struct multishot_recv_op {
+        using result_type = io::recv_result;
+
+        void prep(io_uring_sqe *sqe) noexcept {
+            io_uring_prep_recv_multishot(sqe, fd, nullptr, 0, flags);
+            sqe->flags |= IOSQE_BUFFER_SELECT;
+            sqe->buf_group = pool->group_id();
+        }
+
+        io::recv_result transform(cqe_entry entry) noexcept {
+            return {
+                entry.result, entry.flags,
+                pool->take(entry.result, entry.flags)};
+        }
+
+        // the buffer goes back to the pool with the result
+        static void drop(io::recv_result &&) noexcept {}
+
+        bool rearm(cqe_entry entry) noexcept {
+            return entry.result == -ENOBUFS && pool->replenish();
+        }
+
+        static io::recv_result cancelled() noexcept {
+            return {-ECANCELED, 0, {}};
+        }
+
+        int fd;
+        int flags;
+        buffer_pool *pool;
+    };
+} // namespace detail
+
+/**
+ * The socket operations below must be awaited inside a coroutine running on
+ * an io_context. Each of them resumes with the cqe result: the byte count
+ * (or the new fd for accept) on success, -errno on failure.
+ */
+namespace io {
+    [[nodiscard]]
+    inline detail::lazy_accept accept(
+        int fd,
+        sockaddr *addr = nullptr,
+        socklen_t *addrlen = nullptr,
+        int flags = 0
+    ) noexcept {
+        return {fd, addr, addrlen, flags};
+    }
+
+    [[nodiscard]]
+    inline detail::lazy_connect
+    connect(int fd, const sockaddr *addr, socklen_t addrlen) noexcept {
+        return {fd, addr, addrlen};
+    }
+
+    [[nodiscard]]
+    inline detail::lazy_recv
+    recv(int fd, std::span<char> buf, int flags = 0) noexcept {
+        return {fd, buf, flags};
+    }
+
+    /**
+     * @brief Receive into a buffer borrowed from the io_context's pool when
+     * the data arrives
+     */
+    [[nodiscard]]
+    inline detail::lazy_recv_pooled
+    recv_pooled(int fd, int flags = 0) noexcept {
+        return {fd, flags};
+    }
+
+    [[nodiscard]]
+    inline detail::lazy_send
+    send(int fd, std::span<const char> buf, int flags = 0) noexcept {
+        return {fd, buf, flags};
+    }
+
+    /**
+     * @brief Send without copying `buf` into the kernel, resumes once the
+     * buffer is released by the kernel. Pays off for large payloads only.
+     */
+    [[nodiscard]]
+    inline detail::lazy_send_zc
+    send_zc(int fd, std::span<const char> buf, int flags = 0) noexcept {
+        return {fd, buf, flags, -1};
+    }
+
+    /**
+     * @brief Zero-copy send from a registered buffer, which also saves the
+     * kernel from pinning the pages
+     * @param buf must lie inside the registered buffer `buf_index`
+     */
+    [[nodiscard]]
+    inline detail::lazy_send_zc send_zc_fixed(
+        int fd, std::span<const char> buf, uint16_t buf_index, int flags = 0
+    ) noexcept {
+        return {fd, buf, flags, buf_index};
+    }
+
+    [[nodiscard]]
+    inline detail::lazy_sendmsg
+    sendmsg(int fd, const msghdr *msg, unsigned flags = 0) noexcept {
+        return {fd, msg, flags};
+    }
+
+    [[nodiscard]]
+    inline detail::lazy_recvmsg
+    recvmsg(int fd, msghdr *msg, unsigned flags = 0) noexcept {
+        return {fd, msg, flags};
+    }
+
+    // `co_await next()` yields an accepted fd or -errno
+    using accept_stream = detail::multishot_stream<detail::multishot_accept_op>;
+
+    // `co_await next()` yields a recv_result with a pooled buffer
+    using recv_stream = detail::multishot_stream<detail::multishot_recv_op>;
+
+    /**
+     * @brief Accept many connections with a single sqe
+     */
+    [[nodiscard]]
+    inline accept_stream accept_multishot(int fd, int flags = 0) {
+        return accept_stream{{fd, flags}};
+    }
+
+    /**
+     * @brief Receive many times with a single sqe, each completion borrows a
+     * buffer from the io_context's pool. The request is re-armed when the
+     * pool runs dry and grows, -ENOBUFS is only reported once the pool has
+     * reached config::buffer_max_num.
+     */
+    [[nodiscard]]
+    inline recv_stream recv_multishot(int fd, int flags = 0) {
+        auto &pool = detail::this_thread.worker->provided_buffers();
+        return recv_stream{{fd, flags, std::addressof(pool)}};
+    }
+} // namespace io
+
+} // namespace taskio
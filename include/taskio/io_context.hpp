@@ -1,17 +1,33 @@
 #pragma once
 
+#include <atomic>
 #include <mutex>
 #include <thread>
+#include <vector>
 
+#include <taskio/context_options.hpp>
 #include <taskio/detail/io_context_info.hpp>
 #include <taskio/detail/thread_info.hpp>
 #include <taskio/detail/worker_meta.hpp>
+#include <taskio/metrics.hpp>
 #include <taskio/task.hpp>
 
 namespace taskio {
 
+namespace detail {
+    struct switch_awaiter;
+    struct async_waiter;
+}
+
+class task_group;
+
 struct io_context {
-    explicit io_context() noexcept {
+    friend struct detail::switch_awaiter;
+    friend struct detail::async_waiter;
+    friend class task_group;
+
+    explicit io_context(const context_options &options = {}) noexcept
+        : options(options) {
         auto &meta = detail::io_context_info;
         std::lock_guard lock(meta.mtx);
         this->id = meta.create_count++;
@@ -24,8 +40,54 @@ struct io_context {
     io_context &operator=(const io_context &) = delete;
     io_context &operator=(io_context &&) = delete;
 
+    /**
+     * @brief Run `task` on this context, thread-safe. From other threads the
+     * task goes through the injection queue and wakes the context up. A task
+     * spawned after the context exited is destroyed unrun, with an error.
+     */
     void spawn(task<void> &&task) noexcept;
 
+    /**
+     * @brief The contexts keep running while idle until release(), so that
+     * threads other than theirs can still spawn on them.
+     *
+     * Quiescence is global: all contexts exit together once none is busy, no
+     * spawn is pending and none is held. A context with nothing to do stays
+     * up as long as another one works, and none can be spawned on once they
+     * exited. Threads that spawn from outside the contexts must hold one
+     * meanwhile.
+     */
+    void hold() noexcept;
+
+    void release() noexcept;
+
+    /**
+     * @brief The number of tasks ready to run on this context, thread-safe.
+     * A hint for producers to back off, not exact while the context runs.
+     */
+    [[nodiscard]]
+    std::size_t ready_depth() const noexcept {
+        return work.task_num();
+    }
+
+    /**
+     * @brief What the context did so far, thread-safe and lock-free. All
+     * zero unless enabled by config::metrics_level.
+     */
+    [[nodiscard]]
+    context_metrics metrics() const noexcept {
+        context_metrics out;
+        work.read_metrics(out);
+        return out;
+    }
+
+    /**
+     * @brief Register `count` fixed buffers of `size` bytes with the ring
+     * when the context starts, see io::acquire_fixed_buffer().
+     * Must be called before start().
+     */
+    void reserve_fixed_buffers(uint32_t count, uint32_t size) noexcept;
+
     void start();
 
     void join();
@@ -39,16 +101,82 @@ struct io_context {
 
     void get_process() noexcept;
 
+    // resume `handle` on this context or a thief, thread-safe
+    void post(std::coroutine_handle<> handle, bool is_stealable) noexcept;
+
+    /**
+     * @brief Park the idle context until more tasks are injected
+     * @return false once every context is idle, the context should exit
+     */
+    bool wait_for_work() noexcept;
+
+    // spin then block as configured, until there is something to do
+    void wait() noexcept;
+
+    /**
+     * @brief Poll for options.spin_time
+     * @return true if tasks became ready, the I/O in flight completed or the
+     * contexts started exiting meanwhile
+     */
+    bool spin() noexcept;
+
+    // wake every context up to exit
+    static void quiesce() noexcept;
+
+    // wake an idle context up to steal if this one has tasks to spare
+    void wake_thief() noexcept;
+
+    /**
+     * @brief Steal from the other contexts, round robin
+     * @return false if nothing was stolen
+     */
+    bool steal_work() noexcept;
+
   private:
 
     alignas(config::cache_line_size) detail::worker_meta work;
 
     std::jthread thread;
 
+    context_options options;
+
+    // the contexts started together with this one, including itself
+    std::vector<io_context *> peers;
+    std::size_t steal_cursor = 0;
+
     __pid_t tid;
 
     config::ctx_id_t id;
     bool stop = false;
+    // set before the thread exists, unlike `thread` it is safe to read from
+    // the threads of the other contexts
+    std::atomic<bool> started{false};
+    // set once the thread stopped taking tasks, see spawn()
+    std::atomic<bool> exited{false};
 };
 
+namespace detail {
+
+    struct switch_awaiter {
+        io_context &target;
+
+        bool await_ready() const noexcept { return this_thread.ctx == &target; }
+
+        void await_suspend(std::coroutine_handle<> current) noexcept {
+            target.post(current, false);
+        }
+
+        constexpr void await_resume() const noexcept {}
+    };
+
+} // namespace detail
+
+/**
+ * @brief `co_await switch_to(ctx)` resumes the current task on `ctx`, the
+ * task must not touch anything owned by its previous context afterwards
+ */
+inline detail::switch_awaiter switch_to(io_context &ctx) noexcept {
+    return detail::switch_awaiter{ctx};
+}
+
 } // namespace taskio
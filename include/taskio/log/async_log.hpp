@@ -0,0 +1,248 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <format>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+
+#include <taskio/config.hpp>
+#include <taskio/detail/thread_info.hpp>
+
+namespace taskio::detail {
+
+enum class log_stream : uint32_t { out, err };
+
+// formats the payload of a record
+using log_decoder = void (*)(const std::byte *payload, std::string &out);
+
+struct log_record_header {
+    // nullptr for the padding up to the end of the ring
+    log_decoder decode;
+    // of the whole record, header included
+    uint32_t size;
+    log_stream stream;
+};
+
+/**
+ * @brief The async log records of one thread, a byte ring with one
+ * producer, the thread, and one consumer, the background writer
+ */
+class log_ring {
+  public:
+    static constexpr std::size_t capacity = config::log_ring_size;
+    static_assert(std::has_single_bit(capacity), "capacity must be 2^n");
+
+    log_ring() : buffer(new std::byte[capacity]) {}
+
+    /**
+     * @brief Producer only
+     * @return where the payload goes, nullptr if there is no room
+     */
+    std::byte *try_reserve(log_decoder decode, log_stream stream,
+                           std::size_t payload) noexcept {
+        if (!fits(payload)) [[unlikely]] {
+            return nullptr;
+        }
+        std::size_t size = record_size(payload);
+
+        std::size_t pos = tail.load(std::memory_order_relaxed);
+        std::size_t to_end = capacity - (pos & mask);
+        std::size_t pad = to_end < size ? to_end : 0;
+        if (pos + pad + size - cached_head > capacity) {
+            cached_head = head.load(std::memory_order_acquire);
+            if (pos + pad + size - cached_head > capacity) {
+                return nullptr;
+            }
+        }
+
+        if (pad != 0) {
+            new (buffer.get() + (pos & mask)) log_record_header{
+                nullptr, static_cast<uint32_t>(pad), stream};
+            pos += pad;
+        }
+        reserved = pos + size;
+        auto *header = new (buffer.get() + (pos & mask))
+            log_record_header{decode, static_cast<uint32_t>(size), stream};
+        return reinterpret_cast<std::byte *>(header + 1);
+    }
+
+    // false if a record of `payload` bytes is never taken
+    static constexpr bool fits(std::size_t payload) noexcept {
+        return record_size(payload) <= capacity / 2;
+    }
+
+    // producer only, publishes the reserved record
+    void commit() noexcept { tail.store(reserved, std::memory_order_release); }
+
+    // producer only, the end of the last record
+    [[nodiscard]]
+    std::size_t end() const noexcept {
+        return tail.load(std::memory_order_relaxed);
+    }
+
+    // the end of the records written out by the writer
+    [[nodiscard]]
+    std::size_t flushed() const noexcept {
+        return written.load(std::memory_order_acquire);
+    }
+
+    void drop() noexcept { dropped.fetch_add(1, std::memory_order_relaxed); }
+
+    // the thread exits, the writer frees the ring once drained
+    void close() noexcept { closed.store(true, std::memory_order_release); }
+
+  private:
+    friend class log_writer;
+
+    static constexpr std::size_t mask = capacity - 1;
+
+    static constexpr std::size_t record_size(std::size_t payload) noexcept {
+        constexpr std::size_t align = sizeof(log_record_header);
+        return (sizeof(log_record_header) + payload + align - 1) &
+               ~(align - 1);
+    }
+
+    const std::unique_ptr<std::byte[]> buffer;
+    // the producer's side
+    alignas(config::cache_line_size) std::atomic<std::size_t> tail{0};
+    std::size_t cached_head = 0;
+    std::size_t reserved = 0;
+    std::atomic<uint64_t> dropped{0};
+    // the consumer's side
+    alignas(config::cache_line_size) std::atomic<std::size_t> head{0};
+    // the end of the records written out, flush() waits for it
+    std::atomic<std::size_t> written{0};
+    // the thread has exited, the ring is freed once drained
+    std::atomic<bool> closed{false};
+};
+
+// the ring of the current thread, registered with the writer on first use
+log_ring &register_log_ring();
+
+// wait until the records of the current thread are written out
+void flush_log() noexcept;
+
+inline log_ring &current_log_ring() {
+    if (this_thread.log == nullptr) [[unlikely]] {
+        return register_log_ring();
+    }
+    return *this_thread.log;
+}
+
+/**
+ * @brief How an argument is copied into a record and read back, strings are
+ * copied with their length and read back as string_view, values bytewise
+ */
+template<typename T>
+struct log_arg {
+    static_assert(std::is_trivially_copyable_v<T>,
+                  "async log arguments must be strings or trivially copyable");
+
+    using decoded_type = T;
+
+    static std::size_t size(const T &) noexcept { return sizeof(T); }
+
+    static std::byte *put(std::byte *out, const T &value) noexcept {
+        std::memcpy(out, std::addressof(value), sizeof(T));
+        return out + sizeof(T);
+    }
+
+    static T get(const std::byte *&in) noexcept {
+        std::array<std::byte, sizeof(T)> bytes;
+        std::memcpy(bytes.data(), in, sizeof(T));
+        in += sizeof(T);
+        return std::bit_cast<T>(bytes);
+    }
+};
+
+template<typename T>
+    requires std::convertible_to<const T &, std::string_view>
+struct log_arg<T> {
+    using decoded_type = std::string_view;
+
+    static std::size_t size(const T &value) noexcept {
+        return sizeof(uint32_t) + std::string_view{value}.size();
+    }
+
+    static std::byte *put(std::byte *out, const T &value) noexcept {
+        std::string_view str{value};
+        auto len = static_cast<uint32_t>(str.size());
+        std::memcpy(out, &len, sizeof(len));
+        std::memcpy(out + sizeof(len), str.data(), len);
+        return out + sizeof(len) + len;
+    }
+
+    static std::string_view get(const std::byte *&in) noexcept {
+        uint32_t len;
+        std::memcpy(&len, in, sizeof(len));
+        std::string_view str{reinterpret_cast<const char *>(in + sizeof(len)),
+                             len};
+        in += sizeof(len) + len;
+        return str;
+    }
+};
+
+// the format string of a record, by address since it outlives the record
+struct log_format {
+    const char *data;
+    std::size_t size;
+};
+
+// formats a record of a call with these argument types, the format string
+// comes first in the payload
+template<typename... Args>
+void decode_log(const std::byte *payload, std::string &out) {
+    auto [data, size] = log_arg<log_format>::get(payload);
+    std::string_view fmt{data, size};
+    // braced init reads the arguments in order
+    std::tuple<typename log_arg<Args>::decoded_type...> values{
+        log_arg<Args>::get(payload)...};
+    std::apply(
+        [&](auto &...args) {
+            std::vformat_to(std::back_inserter(out), fmt,
+                            std::make_format_args(args...));
+        },
+        values);
+}
+
+// the payload of a record of these arguments, format string included
+template<typename... Args>
+std::size_t log_payload(const Args &...args) noexcept {
+    return sizeof(log_format) +
+           (log_arg<std::decay_t<Args>>::size(args) + ... + 0);
+}
+
+/**
+ * @brief Copy a record into the ring of the current thread, nothing is
+ * formatted here. The format string must outlive the call, literals do.
+ * @return false if there was no room
+ */
+template<typename... Args>
+bool try_async_log(log_stream stream, std::string_view fmt,
+                   Args &&...args) {
+    log_ring &ring = current_log_ring();
+    log_format format{fmt.data(), fmt.size()};
+    std::byte *out = ring.try_reserve(&decode_log<std::decay_t<Args>...>,
+                                      stream, log_payload(args...));
+    if (out == nullptr) [[unlikely]] {
+        return false;
+    }
+
+    out = log_arg<log_format>::put(out, format);
+    ((out = log_arg<std::decay_t<Args>>::put(out, args)), ...);
+    ring.commit();
+    return true;
+}
+
+} // namespace taskio::detail
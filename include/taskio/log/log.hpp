@@ -1,53 +1,105 @@
 #pragma once
 
+#include <cstdio>
 #include <format>
+#include <string>
+#include <string_view>
+#include <thread>
 
 #include <taskio/config.hpp>
+#include <taskio/log/async_log.hpp>
 
 namespace taskio {
 
 namespace detail {
     template<typename... Args>
-    void log(std::string_view fmt, Args &&...args) {
+    void write_log(std::FILE *file, std::string_view fmt, Args &...args) {
         auto fmt_args{std::make_format_args(args...)};
         std::string output{std::vformat(fmt, fmt_args)};
-        std::fputs(output.c_str(), stdout);
+        std::fputs(output.c_str(), file);
     }
 
+    // the async backend of log(), the record is dropped if the ring is full
     template<typename... Args>
-    void err(std::string_view fmt, Args &&...args) {
-        auto fmt_args{std::make_format_args(args...)};
-        std::string output{std::vformat(fmt, fmt_args)};
-        std::fputs(output.c_str(), stderr);
+    void log_to_ring(std::string_view fmt, Args &...args) {
+        if (!try_async_log(log_stream::out, fmt, args...)) [[unlikely]] {
+            current_log_ring().drop();
+        }
+    }
+
+    // the async backend of err(), the record is never dropped
+    template<typename... Args>
+    void err_to_ring(std::string_view fmt, Args &...args) {
+        // the record must not be lost, it often precedes a terminate
+        while (!try_async_log(log_stream::err, fmt, args...)) [[unlikely]] {
+            if (!log_ring::fits(log_payload(args...))) {
+                // never taken by the ring, written after what it holds
+                flush_log();
+                write_log(stderr, fmt, args...);
+                return;
+            }
+            std::this_thread::yield();
+        }
+    }
+
+    template<typename... Args>
+    void log(std::format_string<Args...> fmt, Args &&...args) {
+        if constexpr (config::async_log) {
+            log_to_ring(fmt.get(), args...);
+        } else {
+            write_log(stdout, fmt.get(), args...);
+        }
+    }
+
+    template<typename... Args>
+    void err(std::format_string<Args...> fmt, Args &&...args) {
+        if constexpr (config::async_log) {
+            err_to_ring(fmt.get(), args...);
+        } else {
+            write_log(stderr, fmt.get(), args...);
+        }
     }
 } // namespace detail
 
 namespace log {
     template<typename... Args>
-    inline void log(std::string_view fmt, Args &&...args) {
+    inline void log(std::format_string<Args...> fmt, Args &&...args) {
         if constexpr (config::is_log_level) {
             detail::log(fmt, std::forward<Args>(args)...);
         }
     }
 
     template<typename... Args>
-    inline void debug(std::string_view fmt, Args &&...args) {
+    inline void debug(std::format_string<Args...> fmt, Args &&...args) {
         if constexpr (config::is_debug_level) {
             detail::log(fmt, std::forward<Args>(args)...);
         }
     }
 
     template<typename... Args>
-    inline void warn(std::string_view fmt, Args &&...args) {
+    inline void warn(std::format_string<Args...> fmt, Args &&...args) {
         if constexpr (config::is_warning_level) {
             detail::err(fmt, std::forward<Args>(args)...);
         }
     }
 
     template<typename... Args>
-    inline void err(std::string_view fmt, Args &&...args) {
+    inline void err(std::format_string<Args...> fmt, Args &&...args) {
         if constexpr (config::is_err_level) {
             detail::err(fmt, std::forward<Args>(args)...);
+            if constexpr (config::async_log) {
+                detail::flush_log();
+            }
+        }
+    }
+
+    /**
+     * @brief Wait until the records logged by the current thread are
+     * written out, a no-op unless config::async_log
+     */
+    inline void flush() noexcept {
+        if constexpr (config::async_log) {
+            detail::flush_log();
         }
     }
 } // namespace log
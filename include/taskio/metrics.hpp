@@ -0,0 +1,144 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+namespace taskio {
+
+/**
+ * @brief An HDR-style histogram of durations in ns: exact below 16, then 16
+ * linear buckets per power of two, within 6.25% of the value up to about
+ * 18 minutes. Longer durations share the last bucket.
+ */
+class latency_histogram {
+  public:
+    static constexpr uint32_t sub_bits = 4;
+    static constexpr uint32_t sub_count = 1u << sub_bits;
+    static constexpr uint32_t max_exp = 40;
+    static constexpr uint32_t bucket_num = (max_exp - sub_bits + 2) * sub_count;
+
+    [[nodiscard]]
+    static constexpr uint32_t bucket_of(uint64_t ns) noexcept {
+        if (ns < sub_count) {
+            return static_cast<uint32_t>(ns);
+        }
+        auto exp = static_cast<uint32_t>(std::bit_width(ns)) - 1;
+        if (exp > max_exp) {
+            return bucket_num - 1;
+        }
+        auto sub =
+            static_cast<uint32_t>(ns >> (exp - sub_bits)) & (sub_count - 1);
+        return (exp - sub_bits + 1) * sub_count + sub;
+    }
+
+    // the largest duration counted in `bucket`
+    [[nodiscard]]
+    static constexpr uint64_t upper_bound(uint32_t bucket) noexcept {
+        if (bucket < sub_count) {
+            return bucket;
+        }
+        uint32_t exp = bucket / sub_count + sub_bits - 1;
+        uint64_t sub = bucket % sub_count;
+        return ((sub_count + sub + 1) << (exp - sub_bits)) - 1;
+    }
+
+    void add(uint32_t bucket, uint64_t num) noexcept { counts[bucket] += num; }
+
+    void merge(const latency_histogram &other) noexcept {
+        for (uint32_t i = 0; i < bucket_num; ++i) {
+            counts[i] += other.counts[i];
+        }
+    }
+
+    [[nodiscard]]
+    uint64_t count() const noexcept {
+        uint64_t total = 0;
+        for (uint64_t num : counts) {
+            total += num;
+        }
+        return total;
+    }
+
+    /**
+     * @param p in [0, 100]
+     * @return the duration that p percent of the samples don't exceed, 0
+     * without samples
+     */
+    [[nodiscard]]
+    std::chrono::nanoseconds percentile(double p) const noexcept {
+        const uint64_t total = count();
+        if (total == 0) {
+            return {};
+        }
+        auto rank =
+            static_cast<uint64_t>(p / 100.0 * static_cast<double>(total));
+        rank = rank == 0 ? 1 : (rank > total ? total : rank);
+
+        uint64_t seen = 0;
+        for (uint32_t i = 0; i < bucket_num; ++i) {
+            seen += counts[i];
+            if (seen >= rank) {
+                return std::chrono::nanoseconds(upper_bound(i));
+            }
+        }
+        return std::chrono::nanoseconds(upper_bound(bucket_num - 1));
+    }
+
+    std::array<uint64_t, bucket_num> counts{};
+};
+
+/**
+ * @brief What an io_context did so far, see config::metrics_level. The
+ * counters are read one by one while the context runs, so they may be a
+ * few events apart from each other.
+ */
+struct context_metrics {
+    // through io_context::spawn and task_group
+    uint64_t spawned = 0;
+    // the coroutines resumed by the loop
+    uint64_t resumed = 0;
+    // the tasks finished on the context, awaited ones included
+    uint64_t completed = 0;
+    // the most tasks waiting in the ready queue at once
+    uint64_t ready_high_water = 0;
+    uint64_t loop_iterations = 0;
+    uint64_t cqes_reaped = 0;
+    // running tasks or polling, against spinning or blocked for work
+    std::chrono::nanoseconds busy{};
+    std::chrono::nanoseconds idle{};
+    // from ready to resumed, for the tasks of the ready queue and the LIFO
+    // slot, needs metric_level::latency
+    latency_histogram ready_latency;
+
+    void merge(const context_metrics &other) noexcept {
+        spawned += other.spawned;
+        resumed += other.resumed;
+        completed += other.completed;
+        if (other.ready_high_water > ready_high_water) {
+            ready_high_water = other.ready_high_water;
+        }
+        loop_iterations += other.loop_iterations;
+        cqes_reaped += other.cqes_reaped;
+        busy += other.busy;
+        idle += other.idle;
+        ready_latency.merge(other.ready_latency);
+    }
+};
+
+struct runtime_metrics {
+    // one per running context
+    std::vector<context_metrics> contexts;
+    // the sum, with the highest ready_high_water
+    context_metrics total;
+};
+
+/**
+ * @brief Read the metrics of every running context, thread-safe. The
+ * contexts are not stopped, their counters are read with relaxed loads.
+ */
+runtime_metrics snapshot_metrics();
+
+} // namespace taskio
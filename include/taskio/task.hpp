@@ -4,10 +4,15 @@
 #include <concepts>
 #include <coroutine>
 #include <exception>
+#include <utility>
 
 #include <taskio/concept/awaitable.hpp>
 #include <taskio/concept/future.hpp>
 #include <taskio/concept/promise.hpp>
+#include <taskio/detail/frame_pool.hpp>
+#include <taskio/detail/metrics.hpp>
+#include <taskio/detail/stop_state.hpp>
+#include <taskio/detail/trace_ring.hpp>
 
 namespace taskio {
 
@@ -19,6 +24,19 @@ namespace detail {
     template<typename T>
     class task_promise_base;
 
+    /**
+     * @brief Finishes a task run as a member of a group, such as when_all,
+     * in place of resuming a parent
+     */
+    struct task_join {
+        // returns the coroutine to resume once `finished` is done
+        using callback = std::coroutine_handle<> (*)(
+            task_join *self, std::coroutine_handle<> finished
+        ) noexcept;
+
+        callback on_finish = nullptr;
+    };
+
     /**
      * @brief When task<> final, resume its parent_coroutine
      */
@@ -29,7 +47,13 @@ namespace detail {
         template<std::derived_from<task_promise_base<T>> Promise>
         std::coroutine_handle<>
         await_suspend(std::coroutine_handle<Promise> current) noexcept {
-            return current.promise().parent_coro;
+            count_completed();
+            trace_event(trace::event_type::final_suspend, current.address());
+            auto &promise = current.promise();
+            if (promise.join != nullptr) {
+                return promise.join->on_finish(promise.join, current);
+            }
+            return promise.parent_coro;
         }
 
         // Won't be resumed anyway
@@ -47,7 +71,12 @@ namespace detail {
         template<std::derived_from<task_promise_base<void>> Promise>
         std::coroutine_handle<>
         await_suspend(std::coroutine_handle<Promise> current) noexcept {
+            count_completed();
+            trace_event(trace::event_type::final_suspend, current.address());
             auto &promise = current.promise();
+            if (promise.join != nullptr) {
+                return promise.join->on_finish(promise.join, current);
+            }
 
             std::coroutine_handle<> continuation = promise.parent_coro;
 
@@ -71,6 +100,15 @@ namespace detail {
 
         task_promise_base() noexcept = default;
 
+        // the frames come from the per-thread pool, not from malloc
+        static void *operator new(std::size_t size) {
+            return frame_pool::allocate(size);
+        }
+
+        static void operator delete(void *ptr) noexcept {
+            frame_pool::deallocate(ptr);
+        }
+
         inline constexpr std::suspend_always initial_suspend() noexcept {
             return {};
         }
@@ -83,6 +121,16 @@ namespace detail {
             parent_coro = continuation;
         }
 
+        // the task reports to `group` when it finishes, not to a parent
+        inline void set_join(task_join *group) noexcept { join = group; }
+
+        inline void set_stop_state(stop_state *state) noexcept {
+            stop = state;
+        }
+
+        // the cancellation state observed by this task, may be nullptr
+        inline stop_state *get_stop_state() const noexcept { return stop; }
+
         task_promise_base(const task_promise_base &) = delete;
         task_promise_base(task_promise_base &&) = delete;
         task_promise_base &operator=(const task_promise_base &) = delete;
@@ -90,6 +138,8 @@ namespace detail {
 
       private:
         std::coroutine_handle<> parent_coro{std::noop_coroutine()};
+        task_join *join = nullptr;
+        stop_state *stop = nullptr;
     };
 
     /**
@@ -117,7 +167,9 @@ namespace detail {
         task<T> get_return_object() noexcept;
 
         void unhandled_exception() noexcept {
-            exception_ptr = std::current_exception();
+            std::construct_at(
+                std::addressof(exception_ptr), std::current_exception()
+            );
             state = value_state::exception;
         }
 
@@ -251,9 +303,16 @@ struct task {
 
         bool await_ready() { return !handle || handle.done(); }
 
+        // the task inherits the cancellation of its awaiter unless it has
+        // its own
+        template<typename Promise>
         std::coroutine_handle<>
-        await_suspend(std::coroutine_handle<> awaiting) {
-            handle.promise().set_parent(awaiting);
+        await_suspend(std::coroutine_handle<Promise> awaiting) {
+            auto &promise = handle.promise();
+            promise.set_parent(awaiting);
+            if (promise.get_stop_state() == nullptr) {
+                promise.set_stop_state(detail::stop_state_of(awaiting));
+            }
             return handle;
         }
     };
@@ -297,6 +356,11 @@ struct task {
 
     std::coroutine_handle<promise_type> get_handle() noexcept { return handle; }
 
+    // give up the frame without detaching it, the caller destroys it
+    std::coroutine_handle<promise_type> release() noexcept {
+        return std::exchange(handle, nullptr);
+    }
+
     /**
      * @brief Overload the co_await operator to get the awaiter
      */
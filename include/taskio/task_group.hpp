@@ -0,0 +1,109 @@
+#pragma once
+
+#include <atomic>
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <optional>
+
+#include <taskio/detail/stop_state.hpp>
+#include <taskio/io_context.hpp>
+#include <taskio/task.hpp>
+
+namespace taskio {
+
+/**
+ * @brief A scope for concurrent children: the tasks spawned into the group
+ * run on the current or any other context, and the owner awaits join() for
+ * all of them before the group goes out of scope.
+ *
+ * The children share the group's stop_state, so the first child to throw
+ * cancels its siblings wherever they run, and join() rethrows that exception
+ * once they are all done. A child's bookkeeping is its own promise, nothing
+ * is allocated besides its frame.
+ */
+class task_group : private detail::task_join {
+  public:
+    // the owner is resumed on the context creating the group, which must be
+    // created on a context
+    task_group() noexcept;
+
+    // must be joined
+    ~task_group();
+
+    task_group(const task_group &) = delete;
+    task_group &operator=(const task_group &) = delete;
+
+    /**
+     * @brief Run `child` on the current context, only callable on one
+     */
+    void spawn(task<void> &&child) noexcept;
+
+    /**
+     * @brief Run `child` on `ctx`, thread-safe
+     */
+    void spawn(io_context &ctx, task<void> &&child) noexcept;
+
+    /**
+     * @brief Thread-safe, stop every child, their pending I/O completes with
+     * -ECANCELED. A stopped group stays stopped.
+     */
+    void cancel() noexcept { stop.request_stop(); }
+
+    [[nodiscard]]
+    bool stop_requested() const noexcept {
+        return stop.stop_requested();
+    }
+
+    // the number of children still running, thread-safe
+    [[nodiscard]]
+    std::size_t size() const noexcept {
+        return running.load(std::memory_order_relaxed) - 1;
+    }
+
+    struct join_awaiter {
+        bool await_ready() const noexcept {
+            return group.running.load(std::memory_order_acquire) == 1;
+        }
+
+        template<typename Promise>
+        bool await_suspend(std::coroutine_handle<Promise> current) noexcept {
+            group.forward.emplace(detail::stop_state_of(current), group.stop);
+            return group.suspend(current);
+        }
+
+        void await_resume() { group.resume(); }
+
+        task_group &group;
+    };
+
+    /**
+     * @brief `co_await` it to wait for every child, rethrows the first
+     * exception a child threw. Stopping the awaiting task cancels the group.
+     */
+    [[nodiscard]]
+    join_awaiter join() noexcept {
+        return {*this};
+    }
+
+  private:
+    void launch(io_context *ctx, task<void> &&child) noexcept;
+
+    bool suspend(std::coroutine_handle<> awaiting) noexcept;
+
+    void resume();
+
+    static std::coroutine_handle<>
+    finish(task_join *self, std::coroutine_handle<> finished) noexcept;
+
+    io_context *home;
+    std::coroutine_handle<> joiner;
+    // one above the children while nobody joins
+    std::atomic<std::size_t> running{1};
+    detail::stop_state stop;
+    std::atomic<bool> failed{false};
+    std::exception_ptr error;
+    std::optional<detail::stop_forwarder> forward;
+};
+
+} // namespace taskio
@@ -0,0 +1,193 @@
+#pragma once
+
+#include <cassert>
+#include <cerrno>
+#include <chrono>
+#include <coroutine>
+#include <cstdint>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+#include <taskio/concept/awaitable.hpp>
+#include <taskio/detail/stop_state.hpp>
+#include <taskio/detail/thread_info.hpp>
+#include <taskio/detail/timer_wheel.hpp>
+#include <taskio/detail/worker_meta.hpp>
+#include <taskio/task.hpp>
+
+namespace taskio {
+
+namespace detail {
+
+    /**
+     * @brief Resumes the awaiting task when the timer expires, or early with
+     * -ECANCELED when the task is asked to stop
+     */
+    struct lazy_sleep : timer_node {
+        explicit lazy_sleep(uint64_t expire_tick) noexcept {
+            this->expire = expire_tick;
+            this->on_expire = &lazy_sleep::on_timer;
+        }
+
+        static constexpr bool await_ready() noexcept { return false; }
+
+        template<typename Promise>
+        bool await_suspend(std::coroutine_handle<Promise> current) noexcept {
+            stop_state *stop = stop_state_of(current);
+            if (stop != nullptr && stop->stop_requested()) [[unlikely]] {
+                result = -ECANCELED;
+                return false;
+            }
+
+            handle = current;
+            this_thread.worker->timers().add(this);
+            if (stop != nullptr) {
+                cancel.self = this;
+                cancel.source = stop;
+                stop->add(&cancel);
+            }
+            return true;
+        }
+
+        // 0 once the deadline passed, -ECANCELED if stopped before
+        int32_t await_resume() noexcept {
+            if (cancel.source != nullptr) {
+                cancel.source->remove(&cancel);
+            }
+            return result;
+        }
+
+      private:
+        struct cancel_node : stop_callback_node {
+            cancel_node() noexcept { this->on_stop = &cancel_node::on_cancel; }
+
+            static void on_cancel(stop_callback_node *node) noexcept {
+                auto *self = static_cast<cancel_node *>(node)->self;
+                self->cancel.source = nullptr;
+                self->result = -ECANCELED;
+                this_thread.worker->timers().remove(self);
+                this_thread.worker->post_task(self->handle);
+            }
+
+            lazy_sleep *self = nullptr;
+            stop_state *source = nullptr;
+        };
+
+        static void on_timer(timer_node *node) noexcept {
+            auto *self = static_cast<lazy_sleep *>(node);
+            // a stop requested from now on must not post the task again
+            if (self->cancel.source != nullptr) {
+                std::exchange(self->cancel.source, nullptr)
+                    ->remove(&self->cancel);
+            }
+            this_thread.worker->post_task(self->handle);
+        }
+
+        std::coroutine_handle<> handle;
+        cancel_node cancel;
+        int32_t result = 0;
+    };
+
+    static_assert(concepts::Awaitable<lazy_sleep>);
+
+    /**
+     * @brief Requests stop on `target` when the deadline passes, disarmed
+     * when it goes out of scope
+     */
+    struct deadline_timer : timer_node {
+        deadline_timer(stop_state &target, uint64_t expire_tick) noexcept
+            : target(target) {
+            this->expire = expire_tick;
+            this->on_expire = &deadline_timer::on_timer;
+            this_thread.worker->timers().add(this);
+        }
+
+        ~deadline_timer() { this_thread.worker->timers().remove(this); }
+
+        deadline_timer(const deadline_timer &) = delete;
+        deadline_timer &operator=(const deadline_timer &) = delete;
+
+      private:
+        static void on_timer(timer_node *node) noexcept {
+            static_cast<deadline_timer *>(node)->target.request_stop();
+        }
+
+        stop_state &target;
+    };
+
+} // namespace detail
+
+/**
+ * @brief Suspend the current task for at least `duration`
+ * @return 0, or -ECANCELED if the task was stopped before
+ */
+template<typename Rep, typename Period>
+inline detail::lazy_sleep
+sleep_for(std::chrono::duration<Rep, Period> duration) noexcept {
+    using clock = detail::timer_wheel::clock;
+    return detail::lazy_sleep{detail::timer_wheel::to_tick(
+        clock::now() + std::chrono::ceil<clock::duration>(duration)
+    )};
+}
+
+/**
+ * @brief Suspend the current task until `deadline`
+ * @return 0, or -ECANCELED if the task was stopped before
+ */
+template<typename Duration>
+inline detail::lazy_sleep sleep_until(
+    std::chrono::time_point<detail::timer_wheel::clock, Duration> deadline
+) noexcept {
+    return detail::lazy_sleep{detail::timer_wheel::to_tick(
+        std::chrono::ceil<detail::timer_wheel::clock::duration>(deadline)
+    )};
+}
+
+/**
+ * @brief The result of with_timeout(): empty if the deadline passed first
+ */
+template<typename T>
+using timeout_result =
+    std::conditional_t<std::is_void_v<T>, bool, std::optional<T>>;
+
+/**
+ * @brief Run `inner` and request it to stop once `timeout` has passed, its
+ * pending I/O is cancelled and its timers return -ECANCELED. `inner` always
+ * runs to completion, its result is dropped if it was stopped. `inner` must
+ * be fresh: not moved from, detached or awaited.
+ * @return the result of `inner`, nullopt (false for task<void>) if stopped
+ */
+template<typename T, typename Rep, typename Period>
+    requires(!std::is_reference_v<T>)
+task<timeout_result<T>>
+with_timeout(task<T> inner, std::chrono::duration<Rep, Period> timeout) {
+    using clock = detail::timer_wheel::clock;
+
+    detail::stop_state stop;
+    // the caller being stopped stops `inner` as well
+    detail::stop_forwarder forward{co_await detail::current_stop_state{}, stop};
+    detail::deadline_timer deadline{
+        stop,
+        detail::timer_wheel::to_tick(
+            clock::now() + std::chrono::ceil<clock::duration>(timeout)
+        )};
+
+    auto handle = inner.get_handle();
+    assert(bool(handle) && "task is empty, moved from or detached");
+    assert(!handle.done() && "task already finished");
+    handle.promise().set_stop_state(&stop);
+
+    if constexpr (std::is_void_v<T>) {
+        co_await std::move(inner);
+        co_return !stop.stop_requested();
+    } else {
+        T result = co_await std::move(inner);
+        if (stop.stop_requested()) {
+            co_return std::nullopt;
+        }
+        co_return std::move(result);
+    }
+}
+
+} // namespace taskio
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <vector>
+
+#include <taskio/context_options.hpp>
+
+namespace taskio {
+
+struct cpu_info {
+    int cpu;
+    // the physical core, its SMT siblings share it
+    int core;
+    int package;
+    // 0 without NUMA
+    int node;
+};
+
+/**
+ * @brief The CPUs this process may run on, read from sysfs, by NUMA node,
+ * package and core so that SMT siblings are next to each other. Without
+ * the topology in sysfs every CPU is a core of its own in package 0.
+ */
+std::vector<cpu_info> available_cpus();
+
+/**
+ * @brief The options of one io_context per physical core, by NUMA node, each
+ * pinned to a CPU of its core and otherwise taken from `base`
+ * @param skip_smt_siblings leave the other CPUs of each core free,
+ * otherwise they get a context too, after one per core
+ */
+std::vector<context_options>
+cpu_layout(bool skip_smt_siblings = true, const context_options &base = {});
+
+} // namespace taskio
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+
+namespace taskio::trace {
+
+enum class event_type : uint16_t {
+    // a task handed to a context, `id` is its frame
+    spawn,
+    // the loop resumes `id`, until the matching suspend
+    resume,
+    // control is back to the loop, `id` is the coroutine it resumed
+    suspend,
+    // task `id` is done
+    final_suspend,
+    // request `id` is submitted, `arg` is its io_uring opcode
+    io_submit,
+    // request `id` completed, `arg` is its result
+    io_complete,
+};
+
+struct event {
+    // in ticks of the TSC, or ns where there is none
+    uint64_t time;
+    uint64_t id;
+    uint32_t arg;
+    event_type type;
+    uint16_t ctx_id;
+};
+
+/**
+ * @brief The layout of a dump: the file header, then per thread a
+ * thread_header followed by its events from oldest to newest
+ */
+struct file_header {
+    static constexpr char magic_value[8] = {
+        'T', 'A', 'S', 'K', 'T', 'R', 'C', '1'};
+    static constexpr uint32_t version_value = 1;
+
+    char magic[8];
+    uint32_t version;
+    uint32_t thread_num;
+    // converts event times to ns since `time_base`
+    double ticks_per_ns;
+    uint64_t time_base;
+};
+
+struct thread_header {
+    uint32_t tid;
+    uint32_t reserved;
+    uint64_t event_num;
+};
+
+/**
+ * @brief Write the events recorded by every thread to `path`, see
+ * config::tracing. Each thread keeps its latest events only, an exited
+ * thread until another thread starts tracing and takes its ring. Events
+ * recorded while dumping may be torn, dump once the contexts are idle or
+ * joined.
+ * @return false with errno set if the file couldn't be written
+ */
+bool dump(const char *path) noexcept;
+
+} // namespace taskio::trace
@@ -17,4 +17,16 @@ inline const std::atomic<T> &as_atomic(const T &value) noexcept {
     return *reinterpret_cast<const std::atomic<T> *>(std::addressof(value));
 }
 
+/**
+ * cast a trivially_copyable type to a std::atomic type, to store to it
+ * @tparam T must be a trivially_copyable type
+ * @param value the value of a trivially_copyable type
+ * @return the value of std::atomic type
+ */
+template<typename T>
+    requires std::is_trivially_copyable_v<T>
+inline std::atomic<T> &as_atomic(T &value) noexcept {
+    return *reinterpret_cast<std::atomic<T> *>(std::addressof(value));
+}
+
 }
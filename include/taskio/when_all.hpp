@@ -0,0 +1,132 @@
+#pragma once
+
+#include <coroutine>
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include <taskio/detail/join_counter.hpp>
+#include <taskio/task.hpp>
+
+namespace taskio {
+
+/**
+ * @brief The value of a task<T> in the result of when_all, std::monostate
+ * for task<void>
+ */
+template<typename T>
+using when_all_value_t =
+    std::conditional_t<std::is_void_v<T>, std::monostate, T>;
+
+namespace detail {
+    template<typename T>
+    inline when_all_value_t<T> take_when_all_value(task<T> &finished) {
+        if constexpr (std::is_void_v<T>) {
+            take_result(finished);
+            return {};
+        } else {
+            return take_result(finished);
+        }
+    }
+
+    template<typename... Ts>
+    struct when_all_awaiter {
+        explicit when_all_awaiter(task<Ts> &&...tasks) noexcept
+            : tasks(std::move(tasks)...), counter(sizeof...(Ts)) {}
+
+        static constexpr bool await_ready() noexcept {
+            return sizeof...(Ts) == 0;
+        }
+
+        template<typename Promise>
+        bool await_suspend(std::coroutine_handle<Promise> current) noexcept {
+            stop_state *stop = stop_state_of(current);
+            std::apply(
+                [&](auto &...member) { (counter.launch(member, stop), ...); },
+                tasks
+            );
+            return counter.suspend(current);
+        }
+
+        // rethrows the first exception in argument order
+        std::tuple<when_all_value_t<Ts>...> await_resume() {
+            return std::apply(
+                [](auto &...member) {
+                    return std::tuple<when_all_value_t<Ts>...>{
+                        take_when_all_value(member)...};
+                },
+                tasks
+            );
+        }
+
+      private:
+        std::tuple<task<Ts>...> tasks;
+        join_counter counter;
+    };
+
+    template<typename T>
+    struct when_all_range_awaiter {
+        explicit when_all_range_awaiter(std::vector<task<T>> &&tasks) noexcept
+            : tasks(std::move(tasks)), counter(this->tasks.size()) {}
+
+        bool await_ready() const noexcept { return tasks.empty(); }
+
+        template<typename Promise>
+        bool await_suspend(std::coroutine_handle<Promise> current) noexcept {
+            stop_state *stop = stop_state_of(current);
+            for (auto &member : tasks) {
+                counter.launch(member, stop);
+            }
+            return counter.suspend(current);
+        }
+
+        // rethrows the first exception in the order of the tasks
+        auto await_resume() {
+            if constexpr (std::is_void_v<T>) {
+                for (auto &member : tasks) {
+                    take_result(member);
+                }
+            } else {
+                std::vector<T> results;
+                results.reserve(tasks.size());
+                for (auto &member : tasks) {
+                    results.push_back(take_result(member));
+                }
+                return results;
+            }
+        }
+
+      private:
+        std::vector<task<T>> tasks;
+        join_counter counter;
+    };
+} // namespace detail
+
+/**
+ * @brief `co_await` it to run every task concurrently and get all of their
+ * values once the last one finishes. The tasks start on the awaiting thread
+ * and inherit the cancellation of the awaiting coroutine. Besides the frames
+ * of the tasks nothing is allocated, the join counter lives in the awaiting
+ * frame. Each task must be fresh: not moved from, detached or awaited.
+ */
+template<typename... Ts>
+[[nodiscard]]
+inline detail::when_all_awaiter<Ts...> when_all(task<Ts>... tasks) noexcept {
+    return detail::when_all_awaiter<Ts...>{std::move(tasks)...};
+}
+
+/**
+ * @brief when_all over a range: resumes with a vector of the values in the
+ * order of `tasks`, or with nothing for task<void>
+ */
+template<typename T>
+[[nodiscard]]
+inline detail::when_all_range_awaiter<T>
+when_all(std::vector<task<T>> tasks) noexcept {
+    return detail::when_all_range_awaiter<T>{std::move(tasks)};
+}
+
+} // namespace taskio
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <coroutine>
+#include <cstddef>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <taskio/detail/join_counter.hpp>
+#include <taskio/detail/stop_state.hpp>
+#include <taskio/task.hpp>
+
+namespace taskio {
+
+/**
+ * @brief The task that finished first and its value
+ */
+template<typename T>
+struct when_any_result {
+    std::size_t index;
+    T value;
+};
+
+template<>
+struct when_any_result<void> {
+    std::size_t index;
+};
+
+namespace detail {
+    /**
+     * @brief The first task to finish requests stop on the stop_state shared
+     * by the others. The awaiting coroutine is resumed only after all of them
+     * are done, so that no cancelled operation outlives its frame.
+     */
+    template<typename T, typename Tasks>
+    struct when_any_awaiter : join_counter {
+        explicit when_any_awaiter(Tasks &&tasks) noexcept
+            : join_counter(tasks.size()), tasks(std::move(tasks)) {
+            assert(!this->tasks.empty());
+            this->on_finish = &when_any_awaiter::finish;
+        }
+
+        static constexpr bool await_ready() noexcept { return false; }
+
+        template<typename Promise>
+        bool await_suspend(std::coroutine_handle<Promise> current) noexcept {
+            // the awaiting coroutine being stopped stops every task
+            forward.emplace(stop_state_of(current), stop);
+            for (auto &member : tasks) {
+                launch(member, &stop);
+            }
+            return suspend(current);
+        }
+
+        // rethrows what the winner threw
+        when_any_result<T> await_resume() {
+            forward.reset();
+            std::size_t index = 0;
+            while (tasks[index].get_handle().address() != winner.load()) {
+                ++index;
+            }
+            if constexpr (std::is_void_v<T>) {
+                take_result(tasks[index]);
+                return {index};
+            } else {
+                return {index, take_result(tasks[index])};
+            }
+        }
+
+      private:
+        static std::coroutine_handle<>
+        finish(task_join *self, std::coroutine_handle<> finished) noexcept {
+            auto *any = static_cast<when_any_awaiter *>(self);
+            void *expected = nullptr;
+            if (any->winner.compare_exchange_strong(
+                    expected, finished.address(), std::memory_order_acq_rel
+                )) {
+                any->stop.request_stop();
+            }
+            return any->arrive();
+        }
+
+        Tasks tasks;
+        stop_state stop;
+        std::atomic<void *> winner{nullptr};
+        // built when suspending, a stop_forwarder can't be moved
+        std::optional<stop_forwarder> forward;
+    };
+} // namespace detail
+
+/**
+ * @brief `co_await` it to run every task concurrently and get the value of
+ * the one that finishes first. The others are cancelled through their
+ * stop_state, their pending I/O is aborted with -ECANCELED, and the awaiting
+ * coroutine resumes once they are all done. The tasks run on the awaiting
+ * thread. Each task must be fresh: not moved from, detached or awaited.
+ */
+template<typename T, typename... Ts>
+    requires(std::same_as<task<T>, Ts> && ...)
+[[nodiscard]]
+inline auto when_any(task<T> first, Ts... rest) noexcept {
+    using tasks_type = std::array<task<T>, sizeof...(Ts) + 1>;
+    return detail::when_any_awaiter<T, tasks_type>{
+        tasks_type{std::move(first), std::move(rest)...}};
+}
+
+/**
+ * @brief when_any over a non-empty range, the index is a position in `tasks`
+ */
+template<typename T>
+[[nodiscard]]
+inline auto when_any(std::vector<task<T>> tasks) noexcept {
+    return detail::when_any_awaiter<T, std::vector<task<T>>>{std::move(tasks)};
+}
+
+} // namespace taskio
@@ -0,0 +1,43 @@
+#include <taskio/async_event.hpp>
+
+namespace taskio {
+
+bool async_event::enqueue(detail::async_waiter *waiter) noexcept {
+    const void *old = state.load(std::memory_order_acquire);
+    do {
+        if (old == this) {
+            return false;
+        }
+        waiter->next.store(
+            static_cast<detail::async_waiter *>(const_cast<void *>(old)),
+            std::memory_order_relaxed);
+    } while (!state.compare_exchange_weak(old, waiter,
+                                          std::memory_order_release,
+                                          std::memory_order_acquire));
+    return true;
+}
+
+void async_event::set() noexcept {
+    const void *old = state.exchange(this, std::memory_order_acq_rel);
+    if (old == this) {
+        return;
+    }
+
+    // resume them in the order they came
+    auto *node = static_cast<detail::async_waiter *>(const_cast<void *>(old));
+    detail::async_waiter *head = nullptr;
+    while (node != nullptr) {
+        auto *next = node->next.load(std::memory_order_relaxed);
+        node->next.store(head, std::memory_order_relaxed);
+        head = node;
+        node = next;
+    }
+    while (head != nullptr) {
+        // the waiter may be gone once resumed
+        auto *next = head->next.load(std::memory_order_relaxed);
+        head->resume();
+        head = next;
+    }
+}
+
+} // namespace taskio
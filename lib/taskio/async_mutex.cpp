@@ -0,0 +1,52 @@
+#include <taskio/async_mutex.hpp>
+
+namespace taskio {
+
+bool async_mutex::enqueue(detail::async_waiter *waiter) noexcept {
+    auto old = state.load(std::memory_order_acquire);
+    while (true) {
+        if (old == not_locked) {
+            if (state.compare_exchange_weak(old, locked_no_waiters,
+                                            std::memory_order_acquire,
+                                            std::memory_order_relaxed)) {
+                return false;
+            }
+        } else {
+            auto *next = reinterpret_cast<detail::async_waiter *>(old);
+            waiter->next.store(next, std::memory_order_relaxed);
+            if (state.compare_exchange_weak(
+                    old, reinterpret_cast<std::uintptr_t>(waiter),
+                    std::memory_order_release, std::memory_order_relaxed)) {
+                return true;
+            }
+        }
+    }
+}
+
+void async_mutex::unlock() noexcept {
+    detail::async_waiter *head = waiters;
+    if (head == nullptr) {
+        auto old = locked_no_waiters;
+        if (state.compare_exchange_strong(old, not_locked,
+                                          std::memory_order_release,
+                                          std::memory_order_relaxed)) {
+            return;
+        }
+
+        // take the pushed waiters and reverse them into FIFO order
+        old = state.exchange(locked_no_waiters, std::memory_order_acquire);
+        auto *node = reinterpret_cast<detail::async_waiter *>(old);
+        while (node != nullptr) {
+            auto *next = node->next.load(std::memory_order_relaxed);
+            node->next.store(head, std::memory_order_relaxed);
+            head = node;
+            node = next;
+        }
+    }
+
+    // the lock is handed over, it is never released in between
+    waiters = head->next.load(std::memory_order_relaxed);
+    head->resume();
+}
+
+} // namespace taskio
@@ -0,0 +1,42 @@
+#include <taskio/async_semaphore.hpp>
+
+#include <algorithm>
+#include <thread>
+
+namespace taskio {
+
+bool async_semaphore::enqueue(detail::async_waiter *waiter) noexcept {
+    if (count.fetch_sub(1, std::memory_order_acquire) > 0) {
+        return false;
+    }
+    waiters.push(waiter);
+    return true;
+}
+
+void async_semaphore::release(std::ptrdiff_t n) noexcept {
+    auto old = count.fetch_add(n, std::memory_order_release);
+    if (old >= 0) {
+        return;
+    }
+
+    auto wake = std::min(n, -old);
+    if (owed.fetch_add(wake, std::memory_order_acq_rel) != 0) {
+        // the current consumer wakes them too
+        return;
+    }
+
+    while (true) {
+        detail::async_waiter *waiter = waiters.pop();
+        if (waiter == nullptr) [[unlikely]] {
+            // counted in but not pushed yet, it is a few instructions away
+            std::this_thread::yield();
+            continue;
+        }
+        waiter->resume();
+        if (owed.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            return;
+        }
+    }
+}
+
+} // namespace taskio
@@ -0,0 +1,16 @@
+#include <taskio/detail/async_waiter.hpp>
+#include <taskio/detail/worker_meta.hpp>
+#include <taskio/io_context.hpp>
+
+namespace taskio::detail {
+
+void async_waiter::resume() noexcept {
+    if (home == this_thread.ctx) {
+        // woken up by the running task, its frame is likely still in cache
+        this_thread.worker->post_next(handle);
+    } else {
+        home->post(handle, false);
+    }
+}
+
+} // namespace taskio::detail
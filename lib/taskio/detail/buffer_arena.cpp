@@ -0,0 +1,96 @@
+#include <cassert>
+#include <cstring>
+
+#include <sys/mman.h>
+#include <sys/uio.h>
+
+#include <taskio/detail/buffer_arena.hpp>
+#include <taskio/io/fixed_buffer.hpp>
+#include <taskio/log/log.hpp>
+
+namespace taskio::detail {
+
+namespace {
+    constexpr std::size_t huge_page_size = 2UL << 20;
+
+    constexpr std::size_t align_up(std::size_t n, std::size_t align) noexcept {
+        return (n + align - 1) & ~(align - 1);
+    }
+} // namespace
+
+void buffer_arena::init(io_uring *ring) noexcept {
+    this->ring = ring;
+    if (buffer_num == 0) {
+        return;
+    }
+
+    const std::size_t total = std::size_t(buffer_num) * buffer_size;
+
+    // explicit huge pages first, they need to be reserved by the admin
+    mapped_size = align_up(total, huge_page_size);
+    void *addr = ::mmap(
+        nullptr, mapped_size, PROT_READ | PROT_WRITE,
+        MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | MAP_POPULATE, -1, 0
+    );
+    huge_page = addr != MAP_FAILED;
+
+    if (!huge_page) {
+        addr = ::mmap(
+            nullptr, mapped_size, PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS, -1, 0
+        );
+        if (addr == MAP_FAILED) [[unlikely]] {
+            log::err("buffer_arena mmap: {}\n", std::strerror(errno));
+            buffer_num = 0;
+            return;
+        }
+        // fall back to transparent huge pages, it is only a hint
+        ::madvise(addr, mapped_size, MADV_HUGEPAGE);
+    }
+    base = static_cast<char *>(addr);
+
+    std::vector<iovec> iovecs(buffer_num);
+    for (uint32_t i = 0; i < buffer_num; ++i) {
+        iovecs[i].iov_base = base + std::size_t(i) * buffer_size;
+        iovecs[i].iov_len = buffer_size;
+    }
+
+    int res = io_uring_register_buffers(ring, iovecs.data(), buffer_num);
+    if (res < 0) [[unlikely]] {
+        log::err("io_uring_register_buffers: {}\n", std::strerror(-res));
+        ::munmap(base, mapped_size);
+        base = nullptr;
+        buffer_num = 0;
+        return;
+    }
+
+    // hand out the low indexes first
+    free_list.reserve(buffer_num);
+    for (uint32_t i = buffer_num; i > 0; --i) {
+        free_list.push_back(static_cast<uint16_t>(i - 1));
+    }
+}
+
+void buffer_arena::deinit() noexcept {
+    if (base == nullptr) {
+        return;
+    }
+
+    assert(free_list.size() == buffer_num && "fixed buffers are still in use");
+    io_uring_unregister_buffers(ring);
+    ::munmap(base, mapped_size);
+    base = nullptr;
+    free_list.clear();
+}
+
+io::fixed_buffer buffer_arena::acquire() noexcept {
+    if (free_list.empty()) [[unlikely]] {
+        return {};
+    }
+
+    uint16_t index = free_list.back();
+    free_list.pop_back();
+    return {this, base + std::size_t(index) * buffer_size, buffer_size, index};
+}
+
+} // namespace taskio::detail
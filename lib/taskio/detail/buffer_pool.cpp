@@ -0,0 +1,93 @@
+#include <cassert>
+#include <cstring>
+#include <exception>
+
+#include <taskio/detail/buffer_pool.hpp>
+#include <taskio/io/buffer.hpp>
+#include <taskio/log/log.hpp>
+
+namespace taskio::detail {
+
+void buffer_pool::deinit() noexcept {
+    if (buf_ring != nullptr) {
+        assert(available_num == buffer_num && "buffers are still borrowed");
+        io_uring_free_buf_ring(
+            ring, buf_ring, config::buffer_max_num, config::buffer_group_id
+        );
+        buf_ring = nullptr;
+    }
+    chunks.clear();
+    buffer_num = 0;
+    available_num = 0;
+}
+
+uint16_t buffer_pool::group_id() noexcept {
+    if (buf_ring == nullptr) [[unlikely]] {
+        int res = 0;
+        buf_ring = io_uring_setup_buf_ring(
+            ring, config::buffer_max_num, config::buffer_group_id, 0, &res
+        );
+        if (buf_ring == nullptr) [[unlikely]] {
+            log::err("io_uring_setup_buf_ring: {}\n", std::strerror(-res));
+            std::terminate();
+        }
+        grow();
+    }
+    return config::buffer_group_id;
+}
+
+io::buffer buffer_pool::take(int32_t result, uint32_t flags) noexcept {
+    if (!(flags & IORING_CQE_F_BUFFER)) {
+        return {};
+    }
+
+    auto bid = static_cast<uint16_t>(flags >> IORING_CQE_BUFFER_SHIFT);
+    --available_num;
+    if (available_num < buffer_num / 4) {
+        // grow before the kernel runs out and fails with -ENOBUFS
+        grow();
+    }
+
+    auto len = result > 0 ? static_cast<uint32_t>(result) : 0;
+    return {this, address(bid), len, bid};
+}
+
+void buffer_pool::recycle(uint16_t bid) noexcept {
+    io_uring_buf_ring_add(
+        buf_ring, address(bid), config::buffer_size, bid,
+        io_uring_buf_ring_mask(config::buffer_max_num), 0
+    );
+    io_uring_buf_ring_advance(buf_ring, 1);
+    ++available_num;
+}
+
+bool buffer_pool::replenish() noexcept {
+    if (available_num < buffer_num / 4) {
+        grow();
+    }
+    return available_num != 0;
+}
+
+void buffer_pool::grow() noexcept {
+    if (buffer_num == config::buffer_max_num) {
+        return;
+    }
+
+    chunks.emplace_back(std::make_unique_for_overwrite<char[]>(
+        std::size_t(config::buffer_chunk_num) * config::buffer_size
+    ));
+
+    const int mask = io_uring_buf_ring_mask(config::buffer_max_num);
+    for (uint16_t i = 0; i < config::buffer_chunk_num; ++i) {
+        auto bid = static_cast<uint16_t>(buffer_num + i);
+        io_uring_buf_ring_add(
+            buf_ring, address(bid), config::buffer_size, bid, mask, i
+        );
+    }
+    io_uring_buf_ring_advance(buf_ring, config::buffer_chunk_num);
+
+    buffer_num += config::buffer_chunk_num;
+    available_num += config::buffer_chunk_num;
+}
+
+} // namespace taskio::detail
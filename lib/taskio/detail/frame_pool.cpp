@@ -0,0 +1,135 @@
+#include <mutex>
+#include <new>
+#include <vector>
+
+#include <taskio/detail/frame_pool.hpp>
+
+namespace taskio::detail {
+
+namespace {
+    // the pools whose thread has exited, never freed since frames of them
+    // may still be alive
+    std::mutex idle_mtx;
+    std::vector<frame_pool *> *idle_pools = new std::vector<frame_pool *>;
+
+    struct pool_guard {
+        frame_pool *pool = nullptr;
+
+        ~pool_guard();
+    };
+
+    thread_local pool_guard guard;
+} // namespace
+
+frame_pool *frame_pool::adopt() {
+    frame_pool *pool = nullptr;
+    {
+        std::lock_guard lock(idle_mtx);
+        if (!idle_pools->empty()) {
+            pool = idle_pools->back();
+            idle_pools->pop_back();
+        }
+    }
+    if (pool == nullptr) {
+        pool = new frame_pool;
+    }
+
+    guard.pool = pool;
+    this_thread.frames = pool;
+    return pool;
+}
+
+pool_guard::~pool_guard() {
+    if (pool == nullptr) {
+        return;
+    }
+    frame_pool::flush_remote();
+    this_thread.frames = nullptr;
+
+    std::lock_guard lock(idle_mtx);
+    idle_pools->push_back(pool);
+}
+
+void *frame_pool::allocate_large(std::size_t total) {
+    auto *h = static_cast<header *>(::operator new(total));
+    h->owner = nullptr;
+    h->size_class = large_class;
+    return h + 1;
+}
+
+void frame_pool::flush_remote() noexcept {
+    if (frame_pool *pool = this_thread.frames) {
+        pool->flush_batch();
+        pool->drain_remote();
+    }
+}
+
+void frame_pool::deallocate_slow(header *h) noexcept {
+    if (h->owner == this) {
+        // the class is cached enough
+        ::operator delete(h);
+        return;
+    }
+
+    if (batch_owner != h->owner || batch_num == config::frame_remote_batch) {
+        flush_batch();
+        batch_owner = h->owner;
+    }
+    next_of(h) = batch_head;
+    batch_head = h;
+    if (batch_tail == nullptr) {
+        batch_tail = h;
+    }
+    ++batch_num;
+}
+
+frame_pool::header *frame_pool::refill(uint32_t size_class) {
+    drain_remote();
+
+    header *h = free_list[size_class];
+    if (h != nullptr) {
+        free_list[size_class] = next_of(h);
+        --free_num[size_class];
+        return h;
+    }
+
+    h = static_cast<header *>(::operator new((size_class + 1) * granule));
+    h->owner = this;
+    h->size_class = size_class;
+    return h;
+}
+
+void frame_pool::drain_remote() noexcept {
+    header *h = remote_head.exchange(nullptr, std::memory_order_acquire);
+    while (h != nullptr) {
+        header *next = next_of(h);
+        if (free_num[h->size_class] < config::frame_pool_cache_num) {
+            next_of(h) = free_list[h->size_class];
+            free_list[h->size_class] = h;
+            ++free_num[h->size_class];
+        } else {
+            ::operator delete(h);
+        }
+        h = next;
+    }
+}
+
+void frame_pool::flush_batch() noexcept {
+    if (batch_head == nullptr) {
+        return;
+    }
+
+    auto &head = batch_owner->remote_head;
+    header *old = head.load(std::memory_order_relaxed);
+    do {
+        next_of(batch_tail) = old;
+    } while (!head.compare_exchange_weak(
+        old, batch_head, std::memory_order_release, std::memory_order_relaxed
+    ));
+
+    batch_owner = nullptr;
+    batch_head = batch_tail = nullptr;
+    batch_num = 0;
+}
+
+} // namespace taskio::detail
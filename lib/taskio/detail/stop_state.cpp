@@ -0,0 +1,78 @@
+#include <taskio/detail/stop_state.hpp>
+#include <taskio/detail/thread_info.hpp>
+#include <taskio/detail/worker_meta.hpp>
+
+namespace taskio::detail {
+
+bool stop_state::add(stop_callback_node *node) noexcept {
+    node->home = this_thread.worker;
+    lock();
+    if (requested.load(std::memory_order_relaxed)) {
+        unlock();
+        return false;
+    }
+    node->prev = nullptr;
+    node->next = head;
+    if (head != nullptr) {
+        head->prev = node;
+    }
+    head = node;
+    node->state = stop_callback_node::node_state::linked;
+    unlock();
+    return true;
+}
+
+void stop_state::remove(stop_callback_node *node) noexcept {
+    lock();
+    if (node->state == stop_callback_node::node_state::linked) {
+        unlink(node);
+        node->state = stop_callback_node::node_state::idle;
+        unlock();
+        return;
+    }
+    unlock();
+
+    // only the home worker moves it on from there
+    if (node->state == stop_callback_node::node_state::queued) {
+        node->home->cancel_stop(node);
+    }
+}
+
+void stop_state::request_stop() noexcept {
+    if (requested.exchange(true, std::memory_order_acq_rel)) {
+        return;
+    }
+
+    worker_meta *self = this_thread.worker;
+    lock();
+    while (head != nullptr) {
+        stop_callback_node *node = head;
+        unlink(node);
+        if (node->home == self || node->home == nullptr) {
+            node->state = stop_callback_node::node_state::idle;
+            // the callback may touch this state or others
+            unlock();
+            node->on_stop(node);
+            lock();
+        } else {
+            // queued under the lock so that remove() can find it
+            node->state = stop_callback_node::node_state::queued;
+            node->home->post_stop(node);
+        }
+    }
+    unlock();
+}
+
+void stop_state::unlink(stop_callback_node *node) noexcept {
+    if (node->prev != nullptr) {
+        node->prev->next = node->next;
+    } else {
+        head = node->next;
+    }
+    if (node->next != nullptr) {
+        node->next->prev = node->prev;
+    }
+    node->prev = node->next = nullptr;
+}
+
+} // namespace taskio::detail
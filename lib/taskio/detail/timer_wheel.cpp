@@ -0,0 +1,148 @@
+#include <algorithm>
+#include <bit>
+#include <limits>
+
+#include <taskio/detail/timer_wheel.hpp>
+
+namespace taskio::detail {
+
+namespace {
+    constexpr uint32_t level_shift(uint32_t level) noexcept {
+        return level * timer_wheel::slot_bits;
+    }
+
+    // one past the last tick a level can hold, relative to the current tick
+    constexpr uint64_t level_span(uint32_t level) noexcept {
+        return uint64_t(1) << level_shift(level + 1);
+    }
+} // namespace
+
+void timer_wheel::add(timer_node *node) noexcept {
+    if (timer_num == 0) {
+        // the wheel doesn't advance while it's empty
+        current = std::max(current, now_tick());
+    }
+    // due timers fire on the next tick
+    link(node, current + 1);
+    ++timer_num;
+}
+
+void timer_wheel::remove(timer_node *node) noexcept {
+    if (node->linked) {
+        unlink(node);
+        --timer_num;
+    }
+}
+
+void timer_wheel::advance(uint64_t tick) noexcept {
+    while (timer_num != 0) {
+        uint64_t next = next_tick();
+        if (next > tick) {
+            break;
+        }
+        current = next;
+
+        // move the timers of the upper slots that come up now down first,
+        // some of them may be due at this very tick
+        for (uint32_t level = level_num - 1; level > 0; --level) {
+            const uint64_t low_bits = (uint64_t(1) << level_shift(level)) - 1;
+            if ((current & low_bits) == 0) {
+                cascade(level);
+            }
+        }
+
+        // callbacks may add or remove timers, but never into this slot
+        timer_node **head = &slots[current & slot_mask];
+        while (*head != nullptr) {
+            timer_node *node = *head;
+            unlink(node);
+            --timer_num;
+            node->on_expire(node);
+        }
+    }
+    current = std::max(current, tick);
+}
+
+uint64_t timer_wheel::next_tick() const noexcept {
+    uint64_t next = std::numeric_limits<uint64_t>::max();
+    for (uint32_t level = 0; level < level_num; ++level) {
+        if (occupied[level] == 0) {
+            continue;
+        }
+
+        // the distance to the nearest occupied slot after the current one,
+        // a whole round if only the current slot is occupied
+        const uint64_t base = current >> level_shift(level);
+        const int index = static_cast<int>(base & slot_mask);
+        const uint64_t rotated = std::rotr(occupied[level], index + 1);
+        const uint64_t distance = std::countr_zero(rotated) + 1;
+
+        next = std::min(next, (base + distance) << level_shift(level));
+    }
+    return next;
+}
+
+void timer_wheel::link(timer_node *node, uint64_t earliest) noexcept {
+    uint64_t expire = std::max(node->expire, earliest);
+    uint64_t delta = expire - current;
+
+    uint32_t level = 0;
+    while (level < level_num - 1 && delta >= level_span(level)) {
+        ++level;
+    }
+    if (delta >= level_span(level)) {
+        // beyond the wheel, park it in the farthest slot and re-link it
+        // when that slot is cascaded
+        expire = current + level_span(level) - 1;
+    }
+
+    const uint64_t index = (expire >> level_shift(level)) & slot_mask;
+    node->slot = static_cast<uint16_t>(level * slot_num + index);
+
+    timer_node *&head = slots[node->slot];
+    node->prev = nullptr;
+    node->next = head;
+    if (head != nullptr) {
+        head->prev = node;
+    }
+    head = node;
+    node->linked = true;
+    occupied[level] |= uint64_t(1) << index;
+}
+
+void timer_wheel::unlink(timer_node *node) noexcept {
+    timer_node *&head = slots[node->slot];
+    if (node->prev != nullptr) {
+        node->prev->next = node->next;
+    } else {
+        head = node->next;
+    }
+    if (node->next != nullptr) {
+        node->next->prev = node->prev;
+    }
+    if (head == nullptr) {
+        occupied[node->slot / slot_num] &=
+            ~(uint64_t(1) << (node->slot % slot_num));
+    }
+    node->prev = node->next = nullptr;
+    node->linked = false;
+}
+
+void timer_wheel::cascade(uint32_t level) noexcept {
+    const uint64_t index = (current >> level_shift(level)) & slot_mask;
+    timer_node *&head = slots[level * slot_num + index];
+
+    // detach the list first, a timer a whole round away lands here again
+    timer_node *node = head;
+    head = nullptr;
+    occupied[level] &= ~(uint64_t(1) << index);
+
+    // a timer due at the current tick goes to its slot, fired right after
+    while (node != nullptr) {
+        timer_node *next = node->next;
+        link(node, current);
+        node = next;
+    }
+}
+
+} // namespace taskio::detail
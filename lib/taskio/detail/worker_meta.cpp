@@ -1,4 +1,15 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <exception>
+#include <utility>
+
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <taskio/detail/io_context_info.hpp>
 #include <taskio/detail/thread_info.hpp>
+#include <taskio/detail/trace_ring.hpp>
 #include <taskio/detail/worker_meta.hpp>
 #include <taskio/log/log.hpp>
 
@@ -8,25 +19,496 @@ namespace taskio::detail {
 
 thread_local thread_info this_thread;
 
-void worker_meta::init() noexcept {
+namespace {
+    // Each io_context is pinned to one thread which is the only submitter
+    // of its ring, so the kernel can skip the locking and defer the task
+    // work to the next io_uring_enter of that thread.
+    constexpr uint32_t ring_setup_flags = IORING_SETUP_SINGLE_ISSUER
+                                        | IORING_SETUP_DEFER_TASKRUN
+                                        | IORING_SETUP_COOP_TASKRUN;
+} // namespace
+
+void worker_meta::init(const context_options &options) noexcept {
     this_thread.worker = this;
+    if constexpr (config::is_counter_metrics) {
+        this_thread.metrics = &metrics;
+        metrics.active_since = metrics_now();
+    }
+
+    io_uring_params params{};
+    params.flags = ring_setup_flags;
+    if (options.sq_poll) {
+        // the kernel thread is the only submitter, task work runs there
+        params.flags = IORING_SETUP_SINGLE_ISSUER | IORING_SETUP_SQPOLL;
+        params.sq_thread_idle =
+            static_cast<uint32_t>(options.sq_poll_idle.count());
+        if (options.sq_poll_cpu >= 0) {
+            params.flags |= IORING_SETUP_SQ_AFF;
+            params.sq_thread_cpu = static_cast<uint32_t>(options.sq_poll_cpu);
+        }
+    }
+
+    int res = io_uring_queue_init_params(config::ring_entries, &ring, &params);
+    if (res < 0 && options.sq_poll) [[unlikely]] {
+        log::warn("io_uring SQPOLL: {}, fall back\n", std::strerror(-res));
+        params = io_uring_params{};
+        params.flags = ring_setup_flags;
+        res = io_uring_queue_init_params(config::ring_entries, &ring, &params);
+    }
+    if (res == -EINVAL) [[unlikely]] {
+        // kernel older than 6.1, fall back to a plain ring
+        log::warn("io_uring setup flags are not supported, fall back\n");
+        params = io_uring_params{};
+        res = io_uring_queue_init_params(config::ring_entries, &ring, &params);
+    }
+
+    if (res < 0) [[unlikely]] {
+        log::err("io_uring_queue_init_params: {}\n", std::strerror(-res));
+        std::terminate();
+    }
+    sq_polled = (ring.flags & IORING_SETUP_SQPOLL) != 0;
+
+    buffers.init(&ring);
+    arena.init(&ring);
+
+    timeout_info.on_complete = &worker_meta::on_ring_timeout;
+
+    if (wakeup_fd < 0) {
+        wakeup_fd = ::eventfd(0, EFD_CLOEXEC);
+    }
+    if (wakeup_fd < 0) [[unlikely]] {
+        log::err("eventfd: {}\n", std::strerror(errno));
+        std::terminate();
+    }
+    arm_wakeup();
 }
 
 void worker_meta::deinit() noexcept {
+    assert(requests_to_reap == 0 && "I/O is still in flight");
+    buffers.deinit();
+    arena.deinit();
+    // also cancels the eventfd read
+    io_uring_queue_exit(&ring);
     this_thread.worker = nullptr;
+    this_thread.metrics = nullptr;
+}
+
+worker_meta::~worker_meta() {
+    if (wakeup_fd >= 0) {
+        ::close(wakeup_fd);
+    }
 }
 
 std::coroutine_handle<> worker_meta::schedule() noexcept {
-    return ready_task.fetch_task();
+    if (next_task) {
+        // out of budget, one task of the ready queue goes first so that the
+        // queue keeps moving, the slot stays hot
+        if (lifo_streak < config::lifo_slot_budget
+            || ready_task.task_num() + stealable.size() == 0) {
+            ++lifo_streak;
+            scheduled_at = next_task_at;
+            return std::exchange(next_task, nullptr);
+        }
+    }
+    lifo_streak = 0;
+
+    // the resumed I/O first, then the tasks no thief took
+    if (ready_task.task_num() != 0) {
+        auto handle = ready_task.fetch_task();
+        scheduled_at = ready_task.fetched_stamp();
+        return handle;
+    }
+    scheduled_at = 0;
+    return stealable.pop(&scheduled_at);
 }
 
 void worker_meta::work_once() noexcept {
-    auto coro = this->schedule();
-    coro.resume();
+    if (auto coro = this->schedule()) [[likely]] {
+        if constexpr (config::is_counter_metrics) {
+            metrics.resumed.add();
+        }
+        if constexpr (config::is_latency_metrics) {
+            if (scheduled_at != 0) {
+                metrics.ready_latency.record(metrics_now() - scheduled_at);
+            }
+        }
+        trace_event(trace::event_type::resume, coro.address());
+        coro.resume();
+        trace_event(trace::event_type::suspend, coro.address());
+    }
 }
 
 void worker_meta::post_task(std::coroutine_handle<> handle) noexcept {
     ready_task.post_task(handle);
+    if constexpr (config::is_counter_metrics) {
+        metrics.ready_high_water.raise(ready_task.task_num());
+    }
+}
+
+void worker_meta::post_next(std::coroutine_handle<> handle) noexcept {
+    if (next_task) {
+        // still ready since it was put in the slot
+        ready_task.post_stamped(next_task, next_task_at);
+        if constexpr (config::is_counter_metrics) {
+            metrics.ready_high_water.raise(ready_task.task_num());
+        }
+    }
+    next_task = handle;
+    if constexpr (config::is_latency_metrics) {
+        next_task_at = metrics_now();
+    }
+}
+
+void worker_meta::post_stealable(std::coroutine_handle<> handle) noexcept {
+    post_stamped(handle, ready_stamp(), true);
+}
+
+void worker_meta::post_stamped(
+    std::coroutine_handle<> handle, uint64_t ready_at, bool is_stealable
+) noexcept {
+    if constexpr (config::work_stealing) {
+        if (is_stealable && stealable.push(handle, ready_at)) [[likely]] {
+            return;
+        }
+    }
+    ready_task.post_stamped(handle, ready_at);
+    if constexpr (config::is_counter_metrics) {
+        metrics.ready_high_water.raise(ready_task.task_num());
+    }
 }
 
+uint32_t worker_meta::steal_from(worker_meta &victim) noexcept {
+    uint32_t num =
+        std::min((victim.stealable_num() + 1) / 2, config::steal_batch);
+
+    uint32_t stolen = 0;
+    for (; stolen < num; ++stolen) {
+        uint64_t ready_at = 0;
+        auto handle = victim.stealable.steal(&ready_at);
+        if (!handle) {
+            break;
+        }
+        post_stamped(handle, ready_at, true);
+    }
+    return stolen;
+}
+
+void worker_meta::inject(
+    std::coroutine_handle<> handle, bool is_stealable
+) noexcept {
+    // counted before it is visible, the drain subtracts it afterwards
+    io_context_info.pending_work.fetch_add(1, std::memory_order_relaxed);
+    const injected_task task{handle, ready_stamp(), is_stealable};
+    if (has_overflow.load(std::memory_order_relaxed)
+        || !injected.try_post(task)) [[unlikely]] {
+        // Waiting for the worker to make room could deadlock: it may be
+        // injecting into the context of this thread, or its wakeup may
+        // still sit in the unsubmitted sqes of this thread.
+        std::lock_guard lock(overflow_mtx);
+        overflow.push_back(task);
+        // seq_cst pairs with the worker checking it before it sleeps
+        has_overflow.store(true, std::memory_order_seq_cst);
+    }
+    if (sleeping.exchange(false, std::memory_order_seq_cst)) {
+        wake();
+    }
+}
+
+bool worker_meta::try_wake() noexcept {
+    if (sleeping.load(std::memory_order_relaxed)
+        && sleeping.exchange(false, std::memory_order_seq_cst)) {
+        wake();
+        return true;
+    }
+    return false;
+}
+
+uint32_t worker_meta::drain_injected() noexcept {
+    uint32_t num = 0;
+    injected_task task;
+    while (injected.try_fetch(task)) {
+        post_stamped(task.handle, task.ready_at, task.is_stealable);
+        ++num;
+    }
+    if (has_overflow.load(std::memory_order_acquire)) [[unlikely]] {
+        {
+            std::lock_guard lock(overflow_mtx);
+            overflow.swap(overflow_spare);
+            has_overflow.store(false, std::memory_order_relaxed);
+        }
+        for (const injected_task &spilled : overflow_spare) {
+            post_stamped(spilled.handle, spilled.ready_at,
+                         spilled.is_stealable);
+        }
+        num += static_cast<uint32_t>(overflow_spare.size());
+        overflow_spare.clear();
+    }
+    if (num != 0) {
+        io_context_info.pending_work.fetch_sub(num, std::memory_order_release);
+    }
+    return num;
+}
+
+void worker_meta::post_stop(stop_callback_node *node) noexcept {
+    {
+        std::lock_guard lock(stops_mtx);
+        node->prev = nullptr;
+        node->next = stops_head;
+        if (stops_head != nullptr) {
+            stops_head->prev = node;
+        }
+        stops_head = node;
+        pending_stops.store(true, std::memory_order_seq_cst);
+    }
+    if (sleeping.exchange(false, std::memory_order_seq_cst)) {
+        wake();
+    }
+}
+
+void worker_meta::cancel_stop(stop_callback_node *node) noexcept {
+    std::lock_guard lock(stops_mtx);
+    if (node->state != stop_callback_node::node_state::queued) {
+        return;
+    }
+    if (node->prev != nullptr) {
+        node->prev->next = node->next;
+    } else {
+        stops_head = node->next;
+    }
+    if (node->next != nullptr) {
+        node->next->prev = node->prev;
+    }
+    node->prev = node->next = nullptr;
+    node->state = stop_callback_node::node_state::idle;
+    if (stops_head == nullptr) {
+        pending_stops.store(false, std::memory_order_relaxed);
+    }
+}
+
+void worker_meta::run_stops_slow() noexcept {
+    for (;;) {
+        stop_callback_node *node;
+        {
+            std::lock_guard lock(stops_mtx);
+            node = stops_head;
+            if (node == nullptr) {
+                pending_stops.store(false, std::memory_order_relaxed);
+                return;
+            }
+            stops_head = node->next;
+            if (stops_head != nullptr) {
+                stops_head->prev = nullptr;
+            }
+            node->next = nullptr;
+            node->state = stop_callback_node::node_state::idle;
+        }
+        // one at a time, a callback may cancel the others
+        node->on_stop(node);
+    }
+}
+
+void worker_meta::wake() noexcept {
+    worker_meta *sender = this_thread.worker;
+    if (sender == nullptr || sender == this) {
+        notify();
+        return;
+    }
+
+    // batched with the other sqes of the sender, no syscall of its own
+    io_uring_sqe *sqe = sender->get_free_sqe();
+    io_uring_prep_msg_ring(
+        sqe, ring.ring_fd, 0, reinterpret_cast<uint64_t>(&wake_info), 0
+    );
+    io_uring_sqe_set_data(sqe, nullptr);
 }
+
+void worker_meta::notify() noexcept {
+    const uint64_t one = 1;
+    if (::write(wakeup_fd, &one, sizeof(one)) < 0) [[unlikely]] {
+        log::err("eventfd write: {}\n", std::strerror(errno));
+    }
+}
+
+void worker_meta::arm_wakeup() noexcept {
+    io_uring_sqe *sqe = get_sqe();
+    io_uring_prep_read(sqe, wakeup_fd, &wakeup_value, sizeof(wakeup_value), 0);
+    io_uring_sqe_set_data(sqe, &wakeup_read_info);
+}
+
+io_uring_sqe *worker_meta::get_free_sqe() noexcept {
+    io_uring_sqe *sqe = get_sqe();
+    ++requests_to_reap;
+    return sqe;
+}
+
+io_uring_sqe *worker_meta::get_sqe() noexcept {
+    io_uring_sqe *sqe = io_uring_get_sqe(&ring);
+    while (sqe == nullptr) [[unlikely]] {
+        // the submission queue is full, hand it over to the kernel
+        if (sq_polled) {
+            io_uring_sqring_wait(&ring);
+        }
+        int res = io_uring_submit(&ring);
+        if (res < 0 && res != -EINTR) {
+            // -EBUSY/-EAGAIN: the completion queue must be drained first
+            reap_completion();
+        }
+        sqe = io_uring_get_sqe(&ring);
+    }
+    return sqe;
+}
+
+void worker_meta::poll_completion() noexcept {
+    if (requests_to_reap == 0) {
+        return;
+    }
+
+    // the polling thread posts the cqes itself, entering the kernel is only
+    // needed to run the deferred task work
+    int res = sq_polled ? io_uring_submit(&ring)
+                        : io_uring_submit_and_get_events(&ring);
+    if (res < 0 && res != -EINTR && res != -EBUSY && res != -EAGAIN)
+        [[unlikely]] {
+        log::err("io_uring_submit_and_get_events: {}\n", std::strerror(-res));
+    }
+    reap_completion();
+}
+
+void worker_meta::wait_completion(std::chrono::milliseconds timeout
+) noexcept {
+    // pairs with inject(): either the injector sees the flag and wakes us,
+    // or we see its task and don't block
+    sleeping.store(true, std::memory_order_seq_cst);
+    if (has_injected() || has_stops()) {
+        sleeping.store(false, std::memory_order_relaxed);
+        poll_completion();
+        return;
+    }
+
+    int res;
+    if (timeout.count() == 0) {
+        res = io_uring_submit_and_wait(&ring, 1);
+    } else {
+        __kernel_timespec spec{
+            .tv_sec = timeout.count() / 1000,
+            .tv_nsec = (timeout.count() % 1000) * 1'000'000};
+        io_uring_cqe *cqe;
+        res = io_uring_submit_and_wait_timeout(&ring, &cqe, 1, &spec, nullptr);
+    }
+    sleeping.store(false, std::memory_order_relaxed);
+    if (res < 0 && res != -EINTR && res != -EBUSY && res != -EAGAIN
+        && res != -ETIME) [[unlikely]] {
+        log::err("io_uring_submit_and_wait: {}\n", std::strerror(-res));
+    }
+    reap_completion();
+}
+
+void worker_meta::advance_timers() noexcept {
+    if (!wheel.empty()) {
+        wheel.advance(timer_wheel::now_tick());
+    }
+}
+
+void worker_meta::sync_ring_timeout() noexcept {
+    if (wheel.empty()) {
+        if (timeout == timeout_state::armed) {
+            // don't keep the context alive for a timer that is gone
+            io_uring_sqe *sqe = get_free_sqe();
+            io_uring_prep_timeout_remove(
+                sqe, reinterpret_cast<uint64_t>(&timeout_info), 0
+            );
+            io_uring_sqe_set_data(sqe, nullptr);
+            timeout = timeout_state::removing;
+        }
+        return;
+    }
+
+    const uint64_t next = wheel.next_tick();
+    if (timeout == timeout_state::removing
+        || (timeout == timeout_state::armed && timeout_tick <= next)) {
+        // a later expiry is picked up once the current timeout fires
+        return;
+    }
+
+    // read by the kernel at submission
+    timeout_spec = timer_wheel::to_timespec(next);
+    timeout_tick = next;
+
+    io_uring_sqe *sqe = get_free_sqe();
+    if (timeout == timeout_state::idle) {
+        io_uring_prep_timeout(sqe, &timeout_spec, 0, IORING_TIMEOUT_ABS);
+        io_uring_sqe_set_data(sqe, &timeout_info);
+    } else {
+        io_uring_prep_timeout_update(
+            sqe,
+            &timeout_spec,
+            reinterpret_cast<uint64_t>(&timeout_info),
+            IORING_TIMEOUT_ABS
+        );
+        io_uring_sqe_set_data(sqe, nullptr);
+    }
+    timeout = timeout_state::armed;
+}
+
+void worker_meta::on_ring_timeout(
+    task_info * /*info*/, int32_t /*result*/, uint32_t /*flags*/
+) noexcept {
+    // expired or removed, the due timers fire in the next advance_timers()
+    this_thread.worker->timeout = timeout_state::idle;
+}
+
+void worker_meta::reap_completion() noexcept {
+    unsigned head;
+    unsigned num = 0;
+    io_uring_cqe *cqe;
+
+    // handle the whole batch, then release the slots to the kernel at once
+    io_uring_for_each_cqe(&ring, head, cqe) {
+        handle_cq_entry(cqe);
+        ++num;
+    }
+    io_uring_cq_advance(&ring, num);
+    if constexpr (config::is_counter_metrics) {
+        metrics.cqes_reaped.add(num);
+    }
+}
+
+void worker_meta::handle_cq_entry(const io_uring_cqe *cqe) noexcept {
+    if (cqe->user_data == LIBURING_UDATA_TIMEOUT) [[unlikely]] {
+        // the timeout liburing queues itself for a wait with a timeout on
+        // kernels without IORING_FEAT_EXT_ARG, never counted as a request
+        return;
+    }
+    auto *info = static_cast<task_info *>(io_uring_cqe_get_data(cqe));
+    if (info == &wakeup_read_info) {
+        arm_wakeup();
+        return;
+    }
+    if (info == &wake_info) {
+        // posted by the ring of another worker, only there to wake us up
+        return;
+    }
+
+    if (!(cqe->flags & IORING_CQE_F_MORE)) {
+        --requests_to_reap;
+    }
+
+    if (info == nullptr) {
+        // internal request that nobody waits for
+        return;
+    }
+    trace_event(
+        trace::event_type::io_complete, info, static_cast<uint32_t>(cqe->res)
+    );
+
+    if (info->on_complete != nullptr) {
+        info->on_complete(info, cqe->res, cqe->flags);
+        return;
+    }
+
+    info->result = cqe->res;
+    info->flags = cqe->flags;
+    post_task(info->handle);
+}
+
+} // namespace taskio::detail
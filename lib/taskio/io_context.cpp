@@ -1,5 +1,11 @@
 #include <taskio/io_context.hpp>
+#include <taskio/detail/affinity.hpp>
+#include <taskio/detail/frame_pool.hpp>
 #include <taskio/detail/thread_info.hpp>
+#include <taskio/detail/trace_ring.hpp>
+#include <taskio/log/log.hpp>
+
+#include <algorithm>
 
 #include <unistd.h>
 
@@ -8,22 +14,41 @@ namespace taskio {
 void io_context::init() noexcept {
     detail::this_thread.ctx_id = this->id;
     detail::this_thread.ctx = this;
-    this->work.init();
+    if (options.cpus.any()) {
+        // before the ring and the pools are allocated, so that they are
+        // local to the CPUs. The worker was built by the creating thread.
+        detail::pin_thread(options.cpus, &work, sizeof(work));
+    }
+    this->work.init(options);
     this->tid = ::gettid();
+
+    auto &meta = detail::io_context_info;
+    std::lock_guard lock(meta.mtx);
+    if (meta.contexts.empty()) {
+        meta.quiescent.store(false, std::memory_order_relaxed);
+    }
+    meta.contexts.push_back(this);
+    // busy until it runs out of work
+    meta.pending_work.fetch_add(1, std::memory_order_relaxed);
 }
 
 void io_context::deinit() noexcept {
     detail::this_thread.ctx_id = -1;
     detail::this_thread.ctx = nullptr;
-    this->work.deinit();
 
     auto &meta = detail::io_context_info;
     std::lock_guard lock(meta.mtx);
+    exited.store(true, std::memory_order_release);
+    // unregistered before the ring is closed by the worker
+    std::erase(meta.contexts, this);
+    this->work.deinit();
+
     meta.create_count--;
     meta.ready_count--;
 }
 
 void io_context::start() {
+    started.store(true, std::memory_order_release);
     thread = std::jthread([this]{
         this->init();
         auto &meta = detail::io_context_info;
@@ -38,6 +63,11 @@ void io_context::start() {
         }
         meta.cv.notify_all();
 
+        if constexpr (config::work_stealing) {
+            std::lock_guard lock(meta.mtx);
+            peers = meta.contexts;
+        }
+
         this->run();
     });
 }
@@ -50,9 +80,35 @@ void io_context::join() {
 
 void io_context::run() {
     while (!stop) [[likely]] {
+        work.count_loop();
+        work.drain_injected();
+        work.run_stops();
+        if constexpr (config::work_stealing) {
+            wake_thief();
+        }
         get_process();
+        work.advance_timers();
+
+        if (work.task_num() != 0) {
+            // more tasks are ready, don't block in the kernel
+            work.poll_completion();
+            continue;
+        }
+
+        // pending timers keep a ring timeout in flight
+        work.sync_ring_timeout();
+        if constexpr (config::work_stealing) {
+            if (steal_work()) {
+                work.poll_completion();
+                continue;
+            }
+        }
+        if (work.has_io_in_flight()) {
+            wait();
+            continue;
+        }
 
-        if (work.task_num() == 0) {
+        if (!work.has_injected() && !work.has_stops() && !wait_for_work()) {
             break;
         }
     }
@@ -60,16 +116,168 @@ void io_context::run() {
     this->deinit();
 }
 
+bool io_context::wait_for_work() noexcept {
+    auto &meta = detail::io_context_info;
+    if (meta.pending_work.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        quiesce();
+        return false;
+    }
+
+    meta.idle_count.fetch_add(1, std::memory_order_relaxed);
+    struct leave_idle {
+        ~leave_idle() {
+            detail::io_context_info.idle_count.fetch_sub(
+                1, std::memory_order_relaxed
+            );
+        }
+    } guard;
+
+    for (;;) {
+        wait();
+        if (meta.quiescent.load(std::memory_order_acquire)) {
+            return false;
+        }
+        if (work.has_injected() || work.has_stops()) {
+            meta.pending_work.fetch_add(1, std::memory_order_acq_rel);
+            return true;
+        }
+
+        if constexpr (config::work_stealing) {
+            // busy again while stealing, so the peers stay alive; zero means
+            // the last one has just quiesced
+            auto &pending = meta.pending_work;
+            if (pending.fetch_add(1, std::memory_order_acq_rel) == 0) {
+                return false;
+            }
+            if (steal_work()) {
+                return true;
+            }
+            if (pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                quiesce();
+                return false;
+            }
+        }
+    }
+}
+
+void io_context::wake_thief() noexcept {
+    if (work.stealable_num() < 2
+        || detail::io_context_info.idle_count.load(std::memory_order_relaxed)
+               == 0) {
+        return;
+    }
+    for (io_context *peer : peers) {
+        if (peer != this && peer->work.try_wake()) {
+            return;
+        }
+    }
+}
+
+bool io_context::steal_work() noexcept {
+    const std::size_t num = peers.size();
+    for (std::size_t i = 0; i < num; ++i) {
+        io_context *victim = peers[(steal_cursor + i) % num];
+        if (victim != this && work.steal_from(victim->work) != 0) {
+            steal_cursor = (steal_cursor + i + 1) % num;
+            return true;
+        }
+    }
+    return false;
+}
+
+void io_context::wait() noexcept {
+    work.begin_idle();
+    if (options.spin_time.count() == 0 || !spin()) {
+        // don't sit on frames other threads could reuse
+        detail::frame_pool::flush_remote();
+        work.wait_completion(options.wait_timeout);
+    }
+    work.end_idle();
+}
+
+bool io_context::spin() noexcept {
+    const auto deadline = std::chrono::steady_clock::now() + options.spin_time;
+    const bool had_io = work.has_io_in_flight();
+    do {
+        work.poll_completion();
+        work.advance_timers();
+        if (work.task_num() != 0 || work.has_injected() || work.has_stops()) {
+            return true;
+        }
+        // internal requests complete without a task, and the wakeup of
+        // quiesce() may have been reaped, blocking would miss both
+        if ((had_io && !work.has_io_in_flight())
+            || detail::io_context_info.quiescent.load(
+                std::memory_order_acquire)) {
+            return true;
+        }
+    } while (std::chrono::steady_clock::now() < deadline);
+    return false;
+}
+
+void io_context::quiesce() noexcept {
+    auto &meta = detail::io_context_info;
+    meta.quiescent.store(true, std::memory_order_release);
+
+    std::lock_guard lock(meta.mtx);
+    for (io_context *ctx : meta.contexts) {
+        ctx->work.notify();
+    }
+}
+
+void io_context::hold() noexcept {
+    detail::io_context_info.pending_work.fetch_add(
+        1, std::memory_order_relaxed
+    );
+}
+
+void io_context::release() noexcept {
+    auto &meta = detail::io_context_info;
+    if (meta.pending_work.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        quiesce();
+    }
+}
+
 void io_context::get_process() noexcept {
     for (auto num = work.task_num(); num > 0; num--) {
         work.work_once();
     }
 }
 
+void io_context::reserve_fixed_buffers(uint32_t count, uint32_t size) noexcept {
+    work.fixed_buffers().reserve(count, size);
+}
+
 void io_context::spawn(task<void> &&task) noexcept {
+    if (exited.load(std::memory_order_acquire)) [[unlikely]] {
+        log::err("spawn on io_context {} after it exited, dropped\n", id);
+        // `task` still owns the frame and destroys it
+        return;
+    }
     auto handle = task.get_handle();
     task.detach();
-    work.post_task(handle);
+    work.count_spawned();
+    detail::trace_event(trace::event_type::spawn, handle.address());
+    post(handle, true);
+}
+
+void io_context::post(
+    std::coroutine_handle<> handle, bool is_stealable
+) noexcept {
+    // before start() only the creating thread touches the context
+    if (detail::this_thread.ctx == this
+        || !started.load(std::memory_order_acquire)) {
+        if (is_stealable) {
+            work.post_stealable(handle);
+        } else {
+            work.post_task(handle);
+        }
+    } else if (exited.load(std::memory_order_acquire)) [[unlikely]] {
+        // nobody would resume it, the task stays suspended
+        log::err("switch to io_context {} after it exited\n", id);
+    } else {
+        work.inject(handle, is_stealable);
+    }
 }
 
 }
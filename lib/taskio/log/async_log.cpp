@@ -0,0 +1,159 @@
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <taskio/log/async_log.hpp>
+
+namespace taskio::detail {
+
+/**
+ * @brief The background thread formatting and writing the records of every
+ * logging thread, started by the first one
+ */
+class log_writer {
+  public:
+    log_writer() : thread([this](std::stop_token stop) { run(stop); }) {}
+
+    // writes what is left
+    ~log_writer() {
+        thread.request_stop();
+        thread.join();
+    }
+
+    void add(log_ring *ring) {
+        std::lock_guard lock(mtx);
+        added.push_back(ring);
+    }
+
+  private:
+    void run(std::stop_token stop) {
+        while (!stop.stop_requested()) {
+            if (!drain()) {
+                std::this_thread::sleep_for(
+                    std::chrono::microseconds(config::log_idle_us));
+            }
+        }
+        drain();
+    }
+
+    // returns false if every ring was empty
+    bool drain() {
+        bool any = false;
+        {
+            // a thread logging for the first time doesn't wait for the
+            // formatting below
+            std::lock_guard lock(mtx);
+            rings.insert(rings.end(), added.begin(), added.end());
+            added.clear();
+        }
+        for (log_ring *ring : rings) {
+            any |= take(*ring);
+        }
+        write(out, stdout);
+        write(err, stderr);
+
+        for (log_ring *ring : rings) {
+            ring->written.store(ring->head.load(std::memory_order_relaxed),
+                                std::memory_order_release);
+        }
+        std::erase_if(rings, [](log_ring *ring) {
+            if (!ring->closed.load(std::memory_order_acquire) ||
+                ring->head.load(std::memory_order_relaxed) !=
+                    ring->tail.load(std::memory_order_acquire)) {
+                return false;
+            }
+            delete ring;
+            return true;
+        });
+        return any;
+    }
+
+    // format the records of `ring` into the batches
+    bool take(log_ring &ring) {
+        std::size_t pos = ring.head.load(std::memory_order_relaxed);
+        std::size_t end = ring.tail.load(std::memory_order_acquire);
+        if (auto n = ring.dropped.exchange(0, std::memory_order_relaxed)) {
+            std::format_to(std::back_inserter(err),
+                           "taskio: {} log records dropped\n", n);
+        }
+        if (pos == end) {
+            return false;
+        }
+
+        while (pos != end) {
+            const auto *header = reinterpret_cast<const log_record_header *>(
+                ring.buffer.get() + (pos & log_ring::mask));
+            if (header->decode != nullptr) {
+                header->decode(reinterpret_cast<const std::byte *>(header + 1),
+                               header->stream == log_stream::out ? out : err);
+            }
+            pos += header->size;
+        }
+        ring.head.store(pos, std::memory_order_release);
+        return true;
+    }
+
+    static void write(std::string &batch, std::FILE *file) {
+        if (batch.empty()) {
+            return;
+        }
+        std::fwrite(batch.data(), 1, batch.size(), file);
+        std::fflush(file);
+        batch.clear();
+    }
+
+    std::mutex mtx;
+    // registered since the last drain, under mtx
+    std::vector<log_ring *> added;
+    // the writer's own
+    std::vector<log_ring *> rings;
+    // the batches formatted by the writer, the storage is kept
+    std::string out;
+    std::string err;
+    std::jthread thread;
+};
+
+namespace {
+    log_writer &writer() {
+        static log_writer instance;
+        return instance;
+    }
+
+    // hands the ring over to the writer when the thread exits
+    struct ring_guard {
+        log_ring *ring = nullptr;
+
+        ~ring_guard() {
+            if (ring != nullptr) {
+                this_thread.log = nullptr;
+                ring->close();
+            }
+        }
+    };
+
+    thread_local ring_guard guard;
+} // namespace
+
+log_ring &register_log_ring() {
+    auto *ring = new log_ring;
+    writer().add(ring);
+    guard.ring = ring;
+    this_thread.log = ring;
+    return *ring;
+}
+
+void flush_log() noexcept {
+    log_ring *ring = this_thread.log;
+    if (ring == nullptr) {
+        return;
+    }
+    std::size_t end = ring->end();
+    while (ring->flushed() < end) {
+        std::this_thread::yield();
+    }
+}
+
+} // namespace taskio::detail
@@ -0,0 +1,21 @@
+#include <mutex>
+
+#include <taskio/detail/io_context_info.hpp>
+#include <taskio/io_context.hpp>
+#include <taskio/metrics.hpp>
+
+namespace taskio {
+
+runtime_metrics snapshot_metrics() {
+    runtime_metrics out;
+    auto &meta = detail::io_context_info;
+    // only keeps the contexts registered, their loops don't take it
+    std::lock_guard lock(meta.mtx);
+    out.contexts.reserve(meta.contexts.size());
+    for (const io_context *ctx : meta.contexts) {
+        out.total.merge(out.contexts.emplace_back(ctx->metrics()));
+    }
+    return out;
+}
+
+} // namespace taskio
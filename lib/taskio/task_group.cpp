@@ -0,0 +1,86 @@
+#include <taskio/task_group.hpp>
+#include <taskio/detail/thread_info.hpp>
+#include <taskio/detail/trace_ring.hpp>
+#include <taskio/log/log.hpp>
+
+#include <cassert>
+#include <utility>
+
+namespace taskio {
+
+task_group::task_group() noexcept : home(detail::this_thread.ctx) {
+    assert(home != nullptr && "task_group created outside of a context");
+    this->on_finish = &task_group::finish;
+}
+
+task_group::~task_group() {
+    if (running.load(std::memory_order_acquire) != 1) [[unlikely]] {
+        log::err("task_group destroyed with {} children running\n", size());
+        std::terminate();
+    }
+}
+
+void task_group::spawn(task<void> &&child) noexcept {
+    assert(detail::this_thread.ctx != nullptr
+           && "task_group::spawn(task) called outside of a context");
+    launch(detail::this_thread.ctx, std::move(child));
+}
+
+void task_group::spawn(io_context &ctx, task<void> &&child) noexcept {
+    launch(&ctx, std::move(child));
+}
+
+void task_group::launch(io_context *ctx, task<void> &&child) noexcept {
+    // the group owns the frame from now on
+    auto handle = child.release();
+
+    auto &promise = handle.promise();
+    promise.set_join(this);
+    if (promise.get_stop_state() == nullptr) {
+        promise.set_stop_state(&stop);
+    }
+    running.fetch_add(1, std::memory_order_relaxed);
+    ctx->work.count_spawned();
+    detail::trace_event(trace::event_type::spawn, handle.address());
+    ctx->post(handle, true);
+}
+
+bool task_group::suspend(std::coroutine_handle<> awaiting) noexcept {
+    joiner = awaiting;
+    return running.fetch_sub(1, std::memory_order_acq_rel) != 1;
+}
+
+void task_group::resume() {
+    running.store(1, std::memory_order_relaxed);
+    forward.reset();
+    if (failed.exchange(false, std::memory_order_acquire)) {
+        std::rethrow_exception(std::exchange(error, nullptr));
+    }
+}
+
+std::coroutine_handle<>
+task_group::finish(task_join *self, std::coroutine_handle<> finished) noexcept {
+    auto *group = static_cast<task_group *>(self);
+    using child_handle = std::coroutine_handle<detail::task_promise<void>>;
+    auto child = child_handle::from_address(finished.address());
+    try {
+        child.promise().result();
+    } catch (...) {
+        if (!group->failed.exchange(true, std::memory_order_acq_rel)) {
+            group->error = std::current_exception();
+            group->stop.request_stop();
+        }
+    }
+    child.destroy();
+
+    if (group->running.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+        return std::noop_coroutine();
+    }
+    if (detail::this_thread.ctx == group->home) {
+        return group->joiner;
+    }
+    group->home->post(group->joiner, false);
+    return std::noop_coroutine();
+}
+
+} // namespace taskio
@@ -0,0 +1,217 @@
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include <linux/mempolicy.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <taskio/detail/affinity.hpp>
+#include <taskio/log/log.hpp>
+#include <taskio/topology.hpp>
+
+namespace taskio {
+
+namespace {
+    // nullopt if sysfs doesn't tell, in a container for instance
+    std::optional<int> read_topology(int cpu, const char *name) {
+        std::ifstream file("/sys/devices/system/cpu/cpu" + std::to_string(cpu)
+                           + "/topology/" + name);
+        int value = 0;
+        file >> value;
+        if (file.fail()) {
+            return std::nullopt;
+        }
+        return value;
+    }
+
+    // the cpu directory links to its node, none without NUMA
+    int node_of(int cpu) {
+        std::error_code ec;
+        std::filesystem::directory_iterator dir(
+            "/sys/devices/system/cpu/cpu" + std::to_string(cpu), ec
+        );
+        for (; !ec && dir != std::filesystem::directory_iterator();
+             dir.increment(ec)) {
+            const std::string name = dir->path().filename().string();
+            int node;
+            if (name.starts_with("node")
+                && std::from_chars(name.data() + 4,
+                                   name.data() + name.size(), node)
+                           .ec
+                       == std::errc{}) {
+                return node;
+            }
+        }
+        return 0;
+    }
+
+    cpu_info read_cpu(int cpu) {
+        auto core = read_topology(cpu, "core_id");
+        auto package = read_topology(cpu, "physical_package_id");
+        if (!core || !package) [[unlikely]] {
+            // otherwise every cpu would count as a sibling of core 0
+            static std::atomic<bool> warned{false};
+            if (!warned.exchange(true, std::memory_order_relaxed)) {
+                log::warn("no cpu topology in sysfs, every cpu counts as a "
+                          "core of its own\n");
+            }
+            core = cpu;
+            package = 0;
+        }
+        return {cpu, *core, *package, node_of(cpu)};
+    }
+} // namespace
+
+std::vector<cpu_info> available_cpus() {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    std::vector<cpu_info> cpus;
+    if (::sched_getaffinity(0, sizeof(set), &set) != 0) {
+        log::warn("sched_getaffinity: {}\n", std::strerror(errno));
+        return cpus;
+    }
+
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+        if (CPU_ISSET(cpu, &set)) {
+            cpus.push_back(read_cpu(cpu));
+        }
+    }
+    std::ranges::sort(cpus, {}, [](const cpu_info &info) {
+        return std::tuple(info.node, info.package, info.core, info.cpu);
+    });
+    return cpus;
+}
+
+std::vector<context_options>
+cpu_layout(bool skip_smt_siblings, const context_options &base) {
+    const std::vector<cpu_info> cpus = available_cpus();
+    // the first CPU of each core, then the second ones and so on
+    std::vector<std::pair<int, int>> order;
+    order.reserve(cpus.size());
+    int sibling = 0;
+    for (std::size_t i = 0; i < cpus.size(); ++i) {
+        const bool same_core = i > 0 && cpus[i].node == cpus[i - 1].node
+                            && cpus[i].package == cpus[i - 1].package
+                            && cpus[i].core == cpus[i - 1].core;
+        sibling = same_core ? sibling + 1 : 0;
+        if (sibling == 0 || !skip_smt_siblings) {
+            order.emplace_back(sibling, static_cast<int>(i));
+        }
+    }
+    std::ranges::stable_sort(order, {}, &std::pair<int, int>::first);
+
+    std::vector<context_options> layout;
+    layout.reserve(order.size());
+    for (const auto &entry : order) {
+        const int cpu = cpus[static_cast<std::size_t>(entry.second)].cpu;
+        if (static_cast<std::size_t>(cpu) >= config::max_cpus) {
+            continue;
+        }
+        context_options &options = layout.emplace_back(base);
+        options.cpus.reset();
+        options.cpus.set(static_cast<std::size_t>(cpu));
+    }
+    return layout;
+}
+
+namespace detail {
+
+    namespace {
+        constexpr std::size_t mask_bits = sizeof(unsigned long) * 8;
+
+        // the node shared by every CPU of `cpus`, -1 if they span several
+        int shared_node(const std::bitset<config::max_cpus> &cpus) {
+            int node = -1;
+            for (std::size_t cpu = 0; cpu < cpus.size(); ++cpu) {
+                if (!cpus.test(cpu)) {
+                    continue;
+                }
+                const int cpu_node = node_of(static_cast<int>(cpu));
+                if (node != -1 && node != cpu_node) {
+                    return -1;
+                }
+                node = cpu_node;
+            }
+            return node;
+        }
+
+        // move the pages spanned by [data, data + size) to `node`, the
+        // neighbours of the data on these pages move along
+        void move_to_node(void *data, std::size_t size, int node) {
+            const auto page_size =
+                static_cast<uintptr_t>(::sysconf(_SC_PAGESIZE));
+            const auto begin = reinterpret_cast<uintptr_t>(data);
+            const uintptr_t first = begin & ~(page_size - 1);
+            const uintptr_t last = (begin + size - 1) & ~(page_size - 1);
+
+            std::vector<void *> pages;
+            for (uintptr_t page = first; page <= last; page += page_size) {
+                pages.push_back(reinterpret_cast<void *>(page));
+            }
+            std::vector<int> nodes(pages.size(), node);
+            std::vector<int> status(pages.size());
+            // best effort, pages in use elsewhere stay where they are
+            ::syscall(SYS_move_pages, 0, pages.size(), pages.data(),
+                      nodes.data(), status.data(), MPOL_MF_MOVE);
+        }
+    } // namespace
+
+    bool pin_thread(
+        const std::bitset<config::max_cpus> &cpus, void *data, std::size_t size
+    ) noexcept {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (std::size_t cpu = 0; cpu < cpus.size() && cpu < CPU_SETSIZE;
+             ++cpu) {
+            if (cpus.test(cpu)) {
+                CPU_SET(cpu, &set);
+            }
+        }
+        if (int res = ::pthread_setaffinity_np(::pthread_self(), sizeof(set),
+                                               &set);
+            res != 0) [[unlikely]] {
+            log::warn("pthread_setaffinity_np: {}\n", std::strerror(res));
+            return false;
+        }
+
+        const int node = shared_node(cpus);
+        if (node < 0
+            || static_cast<std::size_t>(node) >= config::max_numa_nodes) {
+            return true;
+        }
+        // Pages are placed on the node of the CPU that touches them first
+        // anyway, unless the process runs with another policy, interleaved
+        // for instance. Nodes without memory fall back to the others.
+        std::array<unsigned long, config::max_numa_nodes / mask_bits> mask{};
+        mask[node / mask_bits] = 1UL << (node % mask_bits);
+        // the kernel ignores the last bit of maxnode
+        if (::syscall(SYS_set_mempolicy, MPOL_PREFERRED, mask.data(),
+                      mask.size() * mask_bits + 1)
+            != 0) {
+            // ENOSYS: a kernel without NUMA, nothing to place
+            if (errno != ENOSYS) {
+                log::warn("set_mempolicy: {}\n", std::strerror(errno));
+            }
+            return true;
+        }
+        move_to_node(data, size, node);
+        return true;
+    }
+
+} // namespace detail
+
+} // namespace taskio
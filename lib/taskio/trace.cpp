@@ -0,0 +1,144 @@
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+#include <unistd.h>
+
+#include <taskio/detail/trace_ring.hpp>
+#include <taskio/trace.hpp>
+
+namespace taskio::detail {
+
+/**
+ * @brief Every ring ever taken. The ring of an exited thread stays in the
+ * dumps until the next thread starting to trace takes it over, so the
+ * rings never outnumber the threads tracing at the same time.
+ */
+struct trace_registry {
+    trace_registry() noexcept
+        : base_time(trace_clock()), base_clock(clock::now()) {}
+
+    trace_ring &add() {
+        const auto tid = static_cast<uint32_t>(::gettid());
+        std::lock_guard lock(mtx);
+        if (!released.empty()) {
+            // the oldest exited thread gives its events up first
+            trace_ring *ring = released.front();
+            released.erase(released.begin());
+            ring->tid = tid;
+            ring->end.store(0, std::memory_order_relaxed);
+            return *ring;
+        }
+        auto *ring = new trace_ring(tid);
+        rings.push_back(ring);
+        return *ring;
+    }
+
+    // the owning thread exits
+    void release(trace_ring *ring) {
+        std::lock_guard lock(mtx);
+        released.push_back(ring);
+    }
+
+    bool dump(std::FILE *file) {
+        std::lock_guard lock(mtx);
+
+        // the tick rate measured over the whole run
+        const uint64_t now_time = trace_clock();
+        const auto elapsed =
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                clock::now() - base_clock);
+
+        trace::file_header header{};
+        std::memcpy(header.magic, trace::file_header::magic_value,
+                    sizeof(header.magic));
+        header.version = trace::file_header::version_value;
+        header.thread_num = static_cast<uint32_t>(rings.size());
+        header.ticks_per_ns =
+            elapsed.count() > 0 ? static_cast<double>(now_time - base_time) /
+                                      static_cast<double>(elapsed.count())
+                                : 1.0;
+        header.time_base = base_time;
+        if (std::fwrite(&header, sizeof(header), 1, file) != 1) {
+            return false;
+        }
+
+        for (const trace_ring *ring : rings) {
+            const uint64_t end = ring->end.load(std::memory_order_acquire);
+            const uint64_t begin =
+                end > trace_ring::capacity ? end - trace_ring::capacity : 0;
+
+            trace::thread_header thread{ring->tid, 0, end - begin};
+            if (std::fwrite(&thread, sizeof(thread), 1, file) != 1) {
+                return false;
+            }
+            for (uint64_t pos = begin; pos != end; ++pos) {
+                const trace::event &event =
+                    ring->events[pos & trace_ring::mask];
+                if (std::fwrite(&event, sizeof(event), 1, file) != 1) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    using clock = std::chrono::steady_clock;
+
+    const uint64_t base_time;
+    const clock::time_point base_clock;
+
+    std::mutex mtx;
+    // never freed, the events of exited threads are dumped too
+    std::vector<trace_ring *> rings;
+    // the rings of exited threads, in exit order
+    std::vector<trace_ring *> released;
+};
+
+namespace {
+    trace_registry &registry() {
+        static trace_registry instance;
+        return instance;
+    }
+
+    // hands the ring back to the registry when the thread exits
+    struct ring_guard {
+        trace_ring *ring = nullptr;
+
+        ~ring_guard() {
+            if (ring != nullptr) {
+                this_thread.trace = nullptr;
+                registry().release(ring);
+            }
+        }
+    };
+
+    thread_local ring_guard guard;
+} // namespace
+
+trace_ring &register_trace_ring() {
+    trace_ring &ring = registry().add();
+    guard.ring = &ring;
+    this_thread.trace = &ring;
+    return ring;
+}
+
+} // namespace taskio::detail
+
+namespace taskio::trace {
+
+bool dump(const char *path) noexcept {
+    std::FILE *file = std::fopen(path, "wb");
+    if (file == nullptr) {
+        return false;
+    }
+    bool written = detail::registry().dump(file);
+    if (std::fclose(file) != 0) {
+        written = false;
+    }
+    return written;
+}
+
+} // namespace taskio::trace
@@ -0,0 +1,209 @@
+/**
+ * async_generator: a producer awaiting I/O and sleeps between its yields,
+ * batches handed out by next_batch() without resuming the producer,
+ * exceptions rethrown from next(), and the consumer's cancellation reaching
+ * the producer.
+ */
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <unistd.h>
+
+#include <taskio/async_generator.hpp>
+#include <taskio/cancellation.hpp>
+#include <taskio/io/file.hpp>
+#include <taskio/io_context.hpp>
+#include <taskio/task.hpp>
+#include <taskio/timer.hpp>
+
+#include "check.hpp"
+
+using namespace std::chrono_literals;
+
+using taskio::async_generator;
+using taskio::io_context;
+using taskio::task;
+using test::check;
+
+namespace io = taskio::io;
+
+namespace {
+
+constexpr int value_num = 8;
+
+template<typename Fn>
+void on_context(Fn &&fn) {
+    io_context ctx;
+    ctx.spawn(fn(ctx));
+    ctx.start();
+    ctx.join();
+}
+
+// yields each byte read from `fd` until the writer closes it
+async_generator<char> read_bytes(int fd) {
+    char buf[4];
+    for (;;) {
+        const int n = co_await io::read(fd, buf);
+        check(n >= 0);
+        if (n == 0) {
+            co_return;
+        }
+        for (int i = 0; i < n; ++i) {
+            co_yield buf[i];
+        }
+    }
+}
+
+async_generator<int> count_slowly(int count) {
+    for (int i = 0; i < count; ++i) {
+        co_await taskio::sleep_for(1ms);
+        co_yield i;
+    }
+}
+
+task<> write_slowly(int fd, std::string_view text) {
+    for (char c : text) {
+        co_await taskio::sleep_for(1ms);
+        check(co_await io::write(fd, std::span(&c, 1)) == 1);
+    }
+    ::close(fd);
+}
+
+task<> producer_awaits(io_context &ctx) {
+    constexpr std::string_view text = "produced";
+    int fds[2];
+    check(::pipe(fds) == 0);
+    ctx.spawn(write_slowly(fds[1], text));
+    std::string read;
+    auto bytes = read_bytes(fds[0]);
+    while (const char *c = co_await bytes.next()) {
+        read.push_back(*c);
+    }
+    check(read == text);
+    // stays at the end
+    check(co_await bytes.next() == nullptr);
+    ::close(fds[0]);
+
+    std::vector<int> values;
+    auto counter = count_slowly(value_num);
+    while (const int *value = co_await counter.next()) {
+        values.push_back(*value);
+    }
+    check(values.size() == std::size_t(value_num));
+    for (int i = 0; i < value_num; ++i) {
+        check(values[i] == i);
+    }
+}
+
+async_generator<int> batches(int &resumed) {
+    const std::array<int, 5> first{0, 1, 2, 3, 4};
+    ++resumed;
+    co_yield std::span<const int>(first);
+    ++resumed;
+    // not handed out, the producer goes on at once
+    co_yield std::span<const int>();
+    const int single = 5;
+    co_yield single;
+    ++resumed;
+}
+
+task<> batches_without_resuming(io_context &) {
+    int resumed = 0;
+    auto gen = batches(resumed);
+    std::span<const int> taken = co_await gen.next_batch(2);
+    check(resumed == 1);
+    check(taken.size() == 2 && taken[0] == 0 && taken[1] == 1);
+    const int *value = co_await gen.next();
+    check(value != nullptr && *value == 2);
+    taken = co_await gen.next_batch();
+    check(taken.size() == 2 && taken[0] == 3 && taken[1] == 4);
+    check(resumed == 1);
+
+    // the empty span was skipped
+    taken = co_await gen.next_batch();
+    check(resumed == 2);
+    check(taken.size() == 1 && taken[0] == 5);
+    taken = co_await gen.next_batch();
+    check(resumed == 3);
+    check(taken.empty());
+
+    // a default generator is at its end
+    async_generator<int> none;
+    check((co_await none.next_batch()).empty());
+    check(co_await none.next() == nullptr);
+}
+
+async_generator<int> fail_after(int count) {
+    for (int i = 0; i < count; ++i) {
+        co_yield i;
+    }
+    throw std::runtime_error("producer");
+}
+
+task<> exception_from_next(io_context &) {
+    auto gen = fail_after(2);
+    std::vector<int> values;
+    std::string_view what;
+    try {
+        while (const int *value = co_await gen.next()) {
+            values.push_back(*value);
+        }
+    } catch (const std::runtime_error &e) {
+        what = e.what();
+    }
+    check(what == "producer");
+    check(values == std::vector<int>{0, 1});
+    // rethrown once
+    check(co_await gen.next() == nullptr);
+}
+
+// yields once, then sleeps until stopped
+async_generator<int> sleep_between(int &result) {
+    co_yield 1;
+    result = co_await taskio::sleep_for(10s);
+    if (result != -ECANCELED) {
+        co_yield 2;
+    }
+}
+
+task<int> consume(async_generator<int> &gen) {
+    int sum = 0;
+    while (const int *value = co_await gen.next()) {
+        sum += *value;
+    }
+    co_return sum;
+}
+
+task<> cancel_later(taskio::cancellation_source &source) {
+    co_await taskio::sleep_for(10ms);
+    source.request_cancellation();
+}
+
+task<> stop_reaches_producer(io_context &ctx) {
+    int result = 0;
+    auto gen = sleep_between(result);
+    taskio::cancellation_source source;
+    ctx.spawn(cancel_later(source));
+    const auto start = std::chrono::steady_clock::now();
+    const int sum =
+        co_await taskio::with_cancellation(consume(gen), source.token());
+    check(sum == 1);
+    check(result == -ECANCELED);
+    check(std::chrono::steady_clock::now() - start < 5s);
+}
+
+} // namespace
+
+int main() {
+    on_context(producer_awaits);
+    on_context(batches_without_resuming);
+    on_context(exception_from_next);
+    on_context(stop_reaches_producer);
+}
@@ -0,0 +1,47 @@
+/**
+ * Cost of awaiting nested task<int>: an operation is one call of a chain
+ * `depth` tasks deep, each awaiting the next and adding to its result, so
+ * it allocates, resumes and destroys `depth` frames.
+ */
+#include <cstdint>
+#include <string>
+
+#include "bench.hpp"
+
+using bench::clock_type;
+using taskio::task;
+
+namespace {
+
+constexpr int depths[] = {1, 4, 16, 64};
+
+task<int> chain(int depth) {
+    if (depth == 1) {
+        co_return 1;
+    }
+    co_return 1 + co_await chain(depth - 1);
+}
+
+task<> call(int depth, uint64_t ops, clock_type::duration &out) {
+    const auto start = clock_type::now();
+    for (uint64_t i = 0; i < ops; ++i) {
+        int res = co_await chain(depth);
+        bench::do_not_optimize(res);
+    }
+    out = clock_type::now() - start;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    bench::suite suite("await_chain", argc, argv);
+    for (int depth : depths) {
+        suite.run("await_chain/depth_" + std::to_string(depth),
+                  1000000 / depth, [depth](uint64_t ops) {
+                      clock_type::duration elapsed{};
+                      bench::run_on_context(call(depth, ops, elapsed));
+                      return elapsed;
+                  });
+    }
+    return suite.finish();
+}
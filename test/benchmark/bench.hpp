@@ -0,0 +1,298 @@
+/**
+ * The harness shared by the benchmarks. Every case runs warmup repetitions
+ * first, then the timed ones. A case that times each of its operations
+ * prints percentiles of those times over every timed repetition. A case
+ * that only times a whole repetition prints the min, median and max of the
+ * mean time per operation of each, there is no tail to show. Options of
+ * every benchmark:
+ *
+ *     --warmup N          untimed repetitions, 3 by default
+ *     --repetitions N     timed repetitions, 20 by default
+ *     --filter TEXT       only the cases whose name contains TEXT
+ *     --json PATH         also write the results, samples included
+ *     --baseline PATH     the --json output of another build, print the
+ *                         change of the median against it
+ *
+ * so that two commits compare with
+ *
+ *     old/bench_spawn --json old.json
+ *     new/bench_spawn --baseline old.json
+ */
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <coroutine>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <numeric>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <taskio/context_options.hpp>
+#include <taskio/detail/thread_info.hpp>
+#include <taskio/detail/worker_meta.hpp>
+#include <taskio/io_context.hpp>
+#include <taskio/task.hpp>
+
+namespace bench {
+
+using clock_type = std::chrono::steady_clock;
+
+// keep the compiler from optimizing `value` and its computation away
+template<typename T>
+inline void do_not_optimize(const T &value) noexcept {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+// requeue the current task at the tail of the ready queue
+struct yield {
+    static constexpr bool await_ready() noexcept { return false; }
+
+    void await_suspend(std::coroutine_handle<> current) noexcept {
+        taskio::detail::this_thread.worker->post_task(current);
+    }
+
+    constexpr void await_resume() const noexcept {}
+};
+
+// run `task` on a context of its own until every task there is done
+inline void run_on_context(
+    taskio::task<> &&task, const taskio::context_options &options = {}
+) {
+    taskio::io_context ctx(options);
+    ctx.spawn(std::move(task));
+    ctx.start();
+    ctx.join();
+}
+
+// nearest rank, `sorted` must not be empty
+inline double percentile(const std::vector<double> &sorted, double p) {
+    const auto num = sorted.size();
+    auto rank = static_cast<std::size_t>(p / 100.0 * double(num) + 0.5);
+    return sorted[std::clamp<std::size_t>(rank, 1, num) - 1];
+}
+
+struct result {
+    std::string name;
+    uint64_t ops;
+    // the mean ns per operation of each repetition, sorted
+    std::vector<double> runs;
+    // the ns of every operation of every repetition, sorted, empty unless
+    // the case times its operations
+    std::vector<double> samples;
+
+    [[nodiscard]]
+    bool per_op() const noexcept {
+        return !samples.empty();
+    }
+
+    // over the operations if timed one by one, else over the repetitions
+    [[nodiscard]]
+    double percentile(double p) const noexcept {
+        return bench::percentile(per_op() ? samples : runs, p);
+    }
+
+    [[nodiscard]]
+    double mean() const noexcept {
+        return std::accumulate(runs.begin(), runs.end(), 0.0) /
+               double(runs.size());
+    }
+};
+
+class suite {
+  public:
+    suite(const char *name, int argc, char **argv) : name(name) {
+        for (int i = 1; i < argc; ++i) {
+            const char *arg = argv[i];
+            const char *value = i + 1 < argc ? argv[i + 1] : nullptr;
+            if (value == nullptr) {
+                usage(argv[0]);
+            } else if (std::strcmp(arg, "--warmup") == 0) {
+                warmup = std::atoi(value);
+            } else if (std::strcmp(arg, "--repetitions") == 0) {
+                repetitions = std::max(std::atoi(value), 1);
+            } else if (std::strcmp(arg, "--filter") == 0) {
+                filter = value;
+            } else if (std::strcmp(arg, "--json") == 0) {
+                json_path = value;
+            } else if (std::strcmp(arg, "--baseline") == 0) {
+                load_baseline(value);
+            } else {
+                usage(argv[0]);
+            }
+            ++i;
+        }
+        std::printf("%-36s %10s %10s %10s %10s %10s %8s\n", name, "ns/op min",
+                    "p50", "p99", "p999", "max", "vs base");
+    }
+
+    suite(const suite &) = delete;
+    suite &operator=(const suite &) = delete;
+
+    /**
+     * @brief Time a case, `body` runs `ops` operations. Either
+     * `body(ops)` returns how long they took, so that it can leave its
+     * setup out, or `body(ops, samples)` appends the ns of each operation
+     * to `samples`.
+     */
+    template<typename F>
+    void run(const std::string &case_name, uint64_t ops, F &&body) {
+        if (!filter.empty() && case_name.find(filter) == std::string::npos) {
+            return;
+        }
+        constexpr bool per_op =
+            std::is_invocable_v<F &, uint64_t, std::vector<double> &>;
+
+        std::vector<double> discarded;
+        for (int i = 0; i < warmup; ++i) {
+            if constexpr (per_op) {
+                discarded.clear();
+                body(ops, discarded);
+            } else {
+                static_cast<void>(body(ops));
+            }
+        }
+
+        result res{case_name, ops, {}, {}};
+        res.runs.reserve(repetitions);
+        if constexpr (per_op) {
+            res.samples.reserve(ops * repetitions);
+        }
+        for (int i = 0; i < repetitions; ++i) {
+            if constexpr (per_op) {
+                const auto first = res.samples.size();
+                body(ops, res.samples);
+                const auto num = res.samples.size() - first;
+                res.runs.push_back(
+                    std::accumulate(res.samples.begin() + first,
+                                    res.samples.end(), 0.0) /
+                    double(std::max<std::size_t>(num, 1)));
+            } else {
+                std::chrono::duration<double, std::nano> elapsed = body(ops);
+                res.runs.push_back(elapsed.count() / double(ops));
+            }
+        }
+        std::sort(res.runs.begin(), res.runs.end());
+        std::sort(res.samples.begin(), res.samples.end());
+        print(res);
+        results.push_back(std::move(res));
+    }
+
+    /**
+     * @brief Write the --json output if asked
+     * @return the exit code of the benchmark
+     */
+    int finish() const {
+        if (json_path == nullptr) {
+            return 0;
+        }
+        std::FILE *file = std::fopen(json_path, "w");
+        if (file == nullptr) {
+            std::perror(json_path);
+            return 1;
+        }
+        std::fprintf(file,
+                     "{\"suite\": \"%s\", \"warmup\": %d, \"repetitions\": %d,"
+                     "\n \"results\": [",
+                     name, warmup, repetitions);
+        // one result per line, see baseline_of()
+        for (std::size_t i = 0; i < results.size(); ++i) {
+            const result &res = results[i];
+            std::fprintf(file,
+                         "%s\n  {\"name\": \"%s\", \"ops\": %llu, "
+                         "\"unit\": \"ns/op\", \"per_op\": %s, \"min\": %.3f, "
+                         "\"p50\": %.3f, ",
+                         i == 0 ? "" : ",", res.name.c_str(),
+                         static_cast<unsigned long long>(res.ops),
+                         res.per_op() ? "true" : "false", res.percentile(0),
+                         res.percentile(50));
+            if (res.per_op()) {
+                std::fprintf(file, "\"p99\": %.3f, \"p999\": %.3f, ",
+                             res.percentile(99), res.percentile(99.9));
+            }
+            std::fprintf(file, "\"max\": %.3f, \"mean\": %.3f, \"runs\": [",
+                         res.percentile(100), res.mean());
+            for (std::size_t j = 0; j < res.runs.size(); ++j) {
+                std::fprintf(file, "%s%.3f", j == 0 ? "" : ", ", res.runs[j]);
+            }
+            std::fprintf(file, "]}");
+        }
+        std::fprintf(file, "\n]}\n");
+        return std::fclose(file) == 0 ? 0 : 1;
+    }
+
+  private:
+    [[noreturn]]
+    static void usage(const char *program) {
+        std::fprintf(stderr,
+                     "usage: %s [--warmup N] [--repetitions N] "
+                     "[--filter TEXT] [--json PATH] [--baseline PATH]\n",
+                     program);
+        std::exit(2);
+    }
+
+    void load_baseline(const char *path) {
+        std::ifstream file(path);
+        if (!file) {
+            std::perror(path);
+            std::exit(1);
+        }
+        baseline.assign(std::istreambuf_iterator<char>(file), {});
+    }
+
+    /**
+     * @brief The median of `case_name` in the --baseline file, written by
+     * finish() of this harness
+     * @return 0 if the case is not there
+     */
+    [[nodiscard]]
+    double baseline_of(const std::string &case_name) const {
+        const std::string key = "{\"name\": \"" + case_name + "\",";
+        auto pos = baseline.find(key);
+        if (pos == std::string::npos) {
+            return 0;
+        }
+        pos = baseline.find("\"p50\": ", pos);
+        if (pos == std::string::npos) {
+            return 0;
+        }
+        return std::strtod(baseline.c_str() + pos + 7, nullptr);
+    }
+
+    void print(const result &res) const {
+        const double p50 = res.percentile(50);
+        char change[16] = "";
+        if (const double base = baseline_of(res.name); base > 0) {
+            std::snprintf(change, sizeof(change), "%+.1f%%",
+                          (p50 / base - 1.0) * 100.0);
+        }
+        // without the time of each operation there is no tail
+        char p99[16] = "-";
+        char p999[16] = "-";
+        if (res.per_op()) {
+            std::snprintf(p99, sizeof(p99), "%.2f", res.percentile(99));
+            std::snprintf(p999, sizeof(p999), "%.2f", res.percentile(99.9));
+        }
+        std::printf("%-36s %10.2f %10.2f %10s %10s %10.2f %8s\n",
+                    res.name.c_str(), res.percentile(0), p50, p99, p999,
+                    res.percentile(100), change);
+        std::fflush(stdout);
+    }
+
+    const char *name;
+    int warmup = 3;
+    int repetitions = 20;
+    std::string filter;
+    const char *json_path = nullptr;
+    std::string baseline;
+    std::vector<result> results;
+};
+
+} // namespace bench
@@ -0,0 +1,76 @@
+/**
+ * Cost of iterating a generator against the plain loop it replaces. An
+ * operation is one element summed, nested generators yield through
+ * elements_of `depth` levels deep.
+ */
+#include <cstdint>
+#include <string>
+
+#include <taskio/generator.hpp>
+
+#include "bench.hpp"
+
+using bench::clock_type;
+using taskio::elements_of;
+using taskio::generator;
+
+namespace {
+
+constexpr uint64_t elements = 10000000;
+constexpr int depths[] = {1, 4, 16};
+
+generator<uint64_t> iota(uint64_t num) {
+    for (uint64_t i = 0; i < num; ++i) {
+        co_yield i;
+    }
+}
+
+generator<uint64_t> nested(uint64_t num, int depth) {
+    if (depth == 1) {
+        co_yield elements_of(iota(num));
+    } else {
+        co_yield elements_of(nested(num, depth - 1));
+    }
+}
+
+clock_type::duration plain_loop(uint64_t ops) {
+    const auto start = clock_type::now();
+    uint64_t sum = 0;
+    for (uint64_t i = 0; i < ops; ++i) {
+        bench::do_not_optimize(i);
+        sum += i;
+    }
+    bench::do_not_optimize(sum);
+    return clock_type::now() - start;
+}
+
+clock_type::duration flat(uint64_t ops) {
+    const auto start = clock_type::now();
+    uint64_t sum = 0;
+    for (uint64_t i : iota(ops)) {
+        sum += i;
+    }
+    bench::do_not_optimize(sum);
+    return clock_type::now() - start;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    bench::suite suite("generator", argc, argv);
+    suite.run("generator/plain_loop", elements, plain_loop);
+    suite.run("generator/flat", elements, flat);
+    for (int depth : depths) {
+        suite.run("generator/nested_" + std::to_string(depth), elements,
+                  [depth](uint64_t ops) {
+                      const auto start = clock_type::now();
+                      uint64_t sum = 0;
+                      for (uint64_t i : nested(ops, depth)) {
+                          sum += i;
+                      }
+                      bench::do_not_optimize(sum);
+                      return clock_type::now() - start;
+                  });
+    }
+    return suite.finish();
+}
@@ -0,0 +1,129 @@
+/**
+ * Wake latency of two tasks passing a baton back and forth while other
+ * tasks keep the ready queue busy. The woken task is either appended to
+ * the ready queue or put in the LIFO slot of the worker. An operation is
+ * one pass, timed from the wake until the woken task resumes.
+ */
+#include <chrono>
+#include <coroutine>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <taskio/detail/thread_info.hpp>
+#include <taskio/detail/worker_meta.hpp>
+
+#include "bench.hpp"
+
+using bench::clock_type;
+using taskio::io_context;
+using taskio::task;
+
+namespace {
+
+constexpr uint64_t passes = 40000;
+constexpr int background_loads[] = {16, 256, 1024};
+
+enum class mode { fifo, lifo };
+
+const char *mode_name(mode m) {
+    return m == mode::fifo ? "ready_queue" : "lifo_slot";
+}
+
+void wake(std::coroutine_handle<> handle, mode m) {
+    auto *worker = taskio::detail::this_thread.worker;
+    if (m == mode::fifo) {
+        worker->post_task(handle);
+    } else {
+        worker->post_next(handle);
+    }
+}
+
+struct baton {
+    // the wake latency of each pass, in ns
+    std::vector<double> &latencies;
+    std::coroutine_handle<> waiter{};
+    clock_type::time_point sent{};
+    bool done = false;
+};
+
+// suspend until the other side passes the baton
+struct receive_baton {
+    baton &b;
+
+    static constexpr bool await_ready() noexcept { return false; }
+
+    void await_suspend(std::coroutine_handle<> current) noexcept {
+        b.waiter = current;
+    }
+
+    void await_resume() const {
+        std::chrono::duration<double, std::nano> latency =
+            clock_type::now() - b.sent;
+        if (!b.done) {
+            b.latencies.push_back(latency.count());
+        }
+    }
+};
+
+void pass_baton(baton &b, mode m) {
+    b.sent = clock_type::now();
+    wake(std::exchange(b.waiter, nullptr), m);
+}
+
+task<> ping(baton &b, mode m, uint64_t ops) {
+    for (uint64_t i = 0; i < ops / 2; ++i) {
+        pass_baton(b, m);
+        co_await receive_baton{b};
+    }
+    b.done = true;
+    pass_baton(b, m);
+}
+
+task<> pong(baton &b, mode m) {
+    for (;;) {
+        co_await receive_baton{b};
+        if (b.done) {
+            co_return;
+        }
+        pass_baton(b, m);
+    }
+}
+
+task<> background(const baton &b) {
+    while (!b.done) {
+        co_await bench::yield{};
+    }
+}
+
+void pass_under_load(uint64_t ops, std::vector<double> &samples, mode m,
+                     int load) {
+    baton b{samples};
+    io_context ctx;
+    // waiting for the first pass before the others run
+    ctx.spawn(pong(b, m));
+    for (int i = 0; i < load; ++i) {
+        ctx.spawn(background(b));
+    }
+    ctx.spawn(ping(b, m, ops));
+    ctx.start();
+    ctx.join();
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    bench::suite suite("lifo_slot", argc, argv);
+    for (int load : background_loads) {
+        for (mode m : {mode::fifo, mode::lifo}) {
+            suite.run(std::string("lifo_slot/") + mode_name(m) + "_load_"
+                          + std::to_string(load),
+                      passes,
+                      [m, load](uint64_t ops, std::vector<double> &samples) {
+                          pass_under_load(ops, samples, m, load);
+                      });
+        }
+    }
+    return suite.finish();
+}
@@ -0,0 +1,114 @@
+/**
+ * Latency of handing work between two contexts: one task hopping back and
+ * forth with switch_to, and two tasks answering each other over channels.
+ * An operation is one hop or one message. The idle context either blocks
+ * in the kernel or spins before it, see context_options::spin_time.
+ */
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include <taskio/channel.hpp>
+
+#include "bench.hpp"
+
+using namespace std::chrono_literals;
+
+using bench::clock_type;
+using taskio::context_options;
+using taskio::io_context;
+using taskio::task;
+
+namespace {
+
+constexpr uint64_t hops = 20000;
+
+task<> hop(io_context &a, io_context &b, uint64_t ops,
+           clock_type::duration &out) {
+    co_await taskio::switch_to(a);
+    const auto start = clock_type::now();
+    for (uint64_t i = 0; i < ops / 2; ++i) {
+        co_await taskio::switch_to(b);
+        co_await taskio::switch_to(a);
+    }
+    out = clock_type::now() - start;
+    b.release();
+}
+
+clock_type::duration switch_hops(uint64_t ops,
+                                 const context_options &options) {
+    clock_type::duration elapsed{};
+    io_context a(options);
+    io_context b(options);
+    // b has nothing to do until the first hop
+    b.hold();
+    a.spawn(hop(a, b, ops, elapsed));
+    a.start();
+    b.start();
+    a.join();
+    b.join();
+    return elapsed;
+}
+
+using channel = taskio::channel<uint64_t, 1>;
+
+struct channels {
+    channel ping;
+    channel pong;
+};
+
+task<> ping(io_context &ctx, channels &ch, uint64_t ops,
+            clock_type::duration &out) {
+    const auto start = clock_type::now();
+    for (uint64_t i = 0; i < ops / 2; ++i) {
+        co_await ch.ping.send(i);
+        bench::do_not_optimize(co_await ch.pong.recv());
+    }
+    out = clock_type::now() - start;
+    ctx.release();
+}
+
+task<> pong(channels &ch, uint64_t ops) {
+    for (uint64_t i = 0; i < ops / 2; ++i) {
+        co_await ch.pong.send(co_await ch.ping.recv());
+    }
+}
+
+clock_type::duration channel_messages(uint64_t ops,
+                                      const context_options &options) {
+    auto ch = std::make_unique<channels>();
+    clock_type::duration elapsed{};
+    io_context a(options);
+    io_context b(options);
+    b.hold();
+    a.spawn(ping(b, *ch, ops, elapsed));
+    b.spawn(pong(*ch, ops));
+    a.start();
+    b.start();
+    a.join();
+    b.join();
+    return elapsed;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    bench::suite suite("ping_pong", argc, argv);
+    const std::pair<const char *, context_options> waits[] = {
+        {"block", context_options{}},
+        {"spin", context_options{.spin_time = 100us}},
+    };
+    for (const auto &[wait, options] : waits) {
+        suite.run(std::string("ping_pong/switch_to_") + wait, hops,
+                  [&options](uint64_t ops) {
+                      return switch_hops(ops, options);
+                  });
+        suite.run(std::string("ping_pong/channel_") + wait, hops,
+                  [&options](uint64_t ops) {
+                      return channel_messages(ops, options);
+                  });
+    }
+    return suite.finish();
+}
@@ -0,0 +1,193 @@
+/**
+ * Throughput of send, send_zc and send_zc_fixed over a loopback TCP
+ * connection. An operation is one payload sent and received. Note that
+ * loopback can't avoid the copy on the receive side, the gain of zero-copy
+ * is larger on a real NIC.
+ */
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <span>
+#include <string>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <taskio/io/file.hpp>
+#include <taskio/io/socket.hpp>
+
+#include "bench.hpp"
+
+using bench::clock_type;
+using taskio::io_context;
+using taskio::task;
+
+namespace io = taskio::io;
+
+namespace {
+
+// moved by each repetition
+constexpr std::size_t bytes_per_run = 64UL << 20;
+constexpr std::size_t payload_sizes[] = {4096, 65536, 1UL << 20};
+
+enum class mode { send, send_zc, send_zc_fixed };
+
+const char *mode_name(mode m) {
+    switch (m) {
+        case mode::send:
+            return "send";
+        case mode::send_zc:
+            return "send_zc";
+        case mode::send_zc_fixed:
+            return "send_zc_fixed";
+    }
+    return "";
+}
+
+struct connection {
+    int sender;
+    int receiver;
+};
+
+connection make_connection() {
+    int listen_fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t len = sizeof(addr);
+    ::bind(listen_fd, reinterpret_cast<sockaddr *>(&addr), len);
+    ::listen(listen_fd, 1);
+    ::getsockname(listen_fd, reinterpret_cast<sockaddr *>(&addr), &len);
+
+    connection conn{};
+    conn.sender = ::socket(AF_INET, SOCK_STREAM, 0);
+    ::connect(conn.sender, reinterpret_cast<sockaddr *>(&addr), len);
+    conn.receiver = ::accept(listen_fd, nullptr, nullptr);
+    ::close(listen_fd);
+
+    int one = 1;
+    ::setsockopt(conn.sender, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    return conn;
+}
+
+task<> try_acquire(bool &acquired) {
+    acquired = bool(io::acquire_fixed_buffer());
+    co_return;
+}
+
+// registering the buffer fails on a low RLIMIT_MEMLOCK for instance
+bool has_fixed_buffer(std::size_t payload) {
+    bool acquired = false;
+    io_context ctx;
+    ctx.reserve_fixed_buffers(1, payload);
+    ctx.spawn(try_acquire(acquired));
+    ctx.start();
+    ctx.join();
+    return acquired;
+}
+
+task<> receive(int fd, std::size_t total, clock_type::time_point &end) {
+    std::vector<char> buf(1UL << 20);
+    std::size_t received = 0;
+    while (received < total) {
+        int n = co_await io::recv(fd, buf);
+        if (n == 0) {
+            // the sender gave up
+            break;
+        }
+        if (n < 0) {
+            std::fprintf(stderr, "recv: %s\n", std::strerror(-n));
+            break;
+        }
+        received += n;
+    }
+    end = clock_type::now();
+}
+
+task<> transmit(int fd, mode m, std::size_t payload, std::size_t total,
+                clock_type::time_point &start) {
+    std::vector<char> heap_buf(payload, 'x');
+    io::fixed_buffer fixed = io::acquire_fixed_buffer();
+    std::span<const char> buf = heap_buf;
+    if (m == mode::send_zc_fixed) {
+        if (!fixed) {
+            std::fprintf(stderr, "%s: no fixed buffer\n", mode_name(m));
+            ::shutdown(fd, SHUT_WR);
+            co_return;
+        }
+        std::memset(fixed.data().data(), 'x', payload);
+        buf = fixed.data().first(payload);
+    }
+
+    start = clock_type::now();
+    std::size_t sent = 0;
+    while (sent < total) {
+        auto chunk = buf.first(std::min(payload, total - sent));
+        int n = 0;
+        switch (m) {
+            case mode::send:
+                n = co_await io::send(fd, chunk);
+                break;
+            case mode::send_zc:
+                n = co_await io::send_zc(fd, chunk);
+                break;
+            case mode::send_zc_fixed:
+                n = co_await io::send_zc_fixed(fd, chunk, fixed.index());
+                break;
+        }
+        if (n <= 0) {
+            std::fprintf(stderr, "%s: %s\n", mode_name(m), std::strerror(-n));
+            ::shutdown(fd, SHUT_WR);
+            co_return;
+        }
+        sent += n;
+    }
+}
+
+clock_type::duration send_payloads(uint64_t ops, mode m,
+                                   std::size_t payload) {
+    connection conn = make_connection();
+    clock_type::time_point start;
+    clock_type::time_point end;
+
+    io_context sender;
+    io_context receiver;
+    sender.reserve_fixed_buffers(1, payload);
+    sender.spawn(transmit(conn.sender, m, payload, ops * payload, start));
+    receiver.spawn(receive(conn.receiver, ops * payload, end));
+    sender.start();
+    receiver.start();
+    sender.join();
+    receiver.join();
+
+    ::close(conn.sender);
+    ::close(conn.receiver);
+    return end - start;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    bench::suite suite("send_zc", argc, argv);
+    for (std::size_t payload : payload_sizes) {
+        const bool fixed = has_fixed_buffer(payload);
+        for (mode m : {mode::send, mode::send_zc, mode::send_zc_fixed}) {
+            if (m == mode::send_zc_fixed && !fixed) {
+                std::fprintf(stderr, "%s: no fixed buffer of %zu B, skipped\n",
+                             mode_name(m), payload);
+                continue;
+            }
+            suite.run(std::string("send_zc/") + mode_name(m) + "_"
+                          + std::to_string(payload),
+                      bytes_per_run / payload, [m, payload](uint64_t ops) {
+                          return send_payloads(ops, m, payload);
+                      });
+        }
+    }
+    return suite.finish();
+}
@@ -0,0 +1,85 @@
+/**
+ * Throughput of io_context::spawn for empty tasks, from a task of the
+ * context itself and from another thread through the injection queue.
+ * An operation is one task spawned, run and destroyed.
+ */
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+#include "bench.hpp"
+
+using bench::clock_type;
+using taskio::io_context;
+using taskio::task;
+
+namespace {
+
+constexpr uint64_t tasks = 100000;
+
+struct state {
+    uint64_t ops = 0;
+    uint64_t done = 0;
+    clock_type::time_point start;
+    clock_type::time_point end;
+};
+
+task<> empty(state &s) {
+    if (++s.done == s.ops) {
+        s.end = clock_type::now();
+    }
+    co_return;
+}
+
+// the tasks run once this one returns to the loop
+task<> spawn_all(io_context &ctx, state &s) {
+    s.start = clock_type::now();
+    for (uint64_t i = 0; i < s.ops; ++i) {
+        ctx.spawn(empty(s));
+    }
+    co_return;
+}
+
+clock_type::duration local(uint64_t ops) {
+    state s;
+    s.ops = ops;
+    io_context ctx;
+    ctx.spawn(spawn_all(ctx, s));
+    ctx.start();
+    ctx.join();
+    return s.end - s.start;
+}
+
+task<> count(std::atomic<uint64_t> &done) {
+    done.fetch_add(1, std::memory_order_release);
+    co_return;
+}
+
+clock_type::duration remote(uint64_t ops) {
+    std::atomic<uint64_t> done{0};
+    io_context ctx;
+    ctx.hold();
+    ctx.start();
+
+    const auto start = clock_type::now();
+    for (uint64_t i = 0; i < ops; ++i) {
+        ctx.spawn(count(done));
+    }
+    while (done.load(std::memory_order_acquire) != ops) {
+        std::this_thread::yield();
+    }
+    const auto elapsed = clock_type::now() - start;
+
+    ctx.release();
+    ctx.join();
+    return elapsed;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    bench::suite suite("spawn", argc, argv);
+    suite.run("spawn/local", tasks, local);
+    suite.run("spawn/remote", tasks, remote);
+    return suite.finish();
+}
@@ -0,0 +1,136 @@
+/**
+ * Cost of passing values through the spsc ring: pushed and popped by one
+ * thread as the ready queue does, between two threads, and through a
+ * channel between tasks of two contexts, one by one or in batches. An
+ * operation is one value through.
+ */
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <thread>
+
+#include <taskio/channel.hpp>
+#include <taskio/detail/co_spsc.hpp>
+#include <taskio/detail/safety.hpp>
+
+#include "bench.hpp"
+
+using bench::clock_type;
+using taskio::io_context;
+using taskio::task;
+
+namespace {
+
+constexpr uint64_t values = 1000000;
+constexpr std::size_t capacity = 1024;
+constexpr std::size_t batch = 64;
+
+template<bool is_thread_safe>
+using ring = taskio::detail::spsc<
+    taskio::config::cur_t, capacity, is_thread_safe, uint64_t>;
+
+clock_type::duration same_thread(uint64_t ops) {
+    auto queue = std::make_unique<ring<taskio::safety::unsafe>>();
+    const auto start = clock_type::now();
+    for (uint64_t i = 0; i < ops; ++i) {
+        uint64_t value = i;
+        static_cast<void>(queue->try_push(std::move(value)));
+        static_cast<void>(queue->try_pop(value));
+        bench::do_not_optimize(value);
+    }
+    return clock_type::now() - start;
+}
+
+clock_type::duration cross_thread(uint64_t ops) {
+    auto queue = std::make_unique<ring<taskio::safety::safe>>();
+    const auto start = clock_type::now();
+    std::jthread producer([&queue, ops] {
+        for (uint64_t i = 0; i < ops; ++i) {
+            uint64_t value = i;
+            while (!queue->try_push(std::move(value))) {
+                std::this_thread::yield();
+            }
+        }
+    });
+    for (uint64_t i = 0; i < ops; ++i) {
+        uint64_t value;
+        while (!queue->try_pop(value)) {
+            std::this_thread::yield();
+        }
+        bench::do_not_optimize(value);
+    }
+    return clock_type::now() - start;
+}
+
+using channel = taskio::channel<uint64_t, capacity>;
+
+task<> send_all(channel &ch, uint64_t ops) {
+    for (uint64_t i = 0; i < ops; ++i) {
+        co_await ch.send(i);
+    }
+}
+
+task<> recv_all(io_context &ctx, channel &ch, uint64_t ops,
+                clock_type::time_point &end) {
+    for (uint64_t i = 0; i < ops; ++i) {
+        bench::do_not_optimize(co_await ch.recv());
+    }
+    end = clock_type::now();
+    ctx.release();
+}
+
+task<> send_batches(channel &ch, uint64_t ops) {
+    uint64_t buf[batch] = {};
+    for (uint64_t sent = 0; sent < ops;) {
+        const auto num = std::min<uint64_t>(batch, ops - sent);
+        sent += co_await ch.send_n(std::span(buf, num));
+    }
+}
+
+task<> recv_batches(io_context &ctx, channel &ch, uint64_t ops,
+                    clock_type::time_point &end) {
+    uint64_t buf[batch];
+    for (uint64_t received = 0; received < ops;) {
+        const auto num = std::min<uint64_t>(batch, ops - received);
+        received += co_await ch.recv_n(std::span(buf, num));
+        bench::do_not_optimize(buf);
+    }
+    end = clock_type::now();
+    ctx.release();
+}
+
+template<bool is_batched>
+clock_type::duration cross_context(uint64_t ops) {
+    auto ch = std::make_unique<channel>();
+    clock_type::time_point end;
+    io_context sender_ctx;
+    io_context receiver_ctx;
+    // the contexts may both be idle while a value is on its way
+    receiver_ctx.hold();
+    if constexpr (is_batched) {
+        sender_ctx.spawn(send_batches(*ch, ops));
+        receiver_ctx.spawn(recv_batches(receiver_ctx, *ch, ops, end));
+    } else {
+        sender_ctx.spawn(send_all(*ch, ops));
+        receiver_ctx.spawn(recv_all(receiver_ctx, *ch, ops, end));
+    }
+
+    const auto start = clock_type::now();
+    sender_ctx.start();
+    receiver_ctx.start();
+    sender_ctx.join();
+    receiver_ctx.join();
+    return end - start;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    bench::suite suite("spsc", argc, argv);
+    suite.run("spsc/same_thread", values, same_thread);
+    suite.run("spsc/cross_thread", values, cross_thread);
+    suite.run("channel/cross_context", values, cross_context<false>);
+    suite.run("channel/cross_context_batch", values, cross_context<true>);
+    return suite.finish();
+}
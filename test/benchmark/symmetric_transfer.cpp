@@ -0,0 +1,96 @@
+/**
+ * Cost of handing the thread from one coroutine to another. Two tasks
+ * resume each other either directly, by returning the other from
+ * await_suspend, or through the ready queue of the loop. An operation is
+ * one switch.
+ */
+#include <algorithm>
+#include <coroutine>
+#include <cstdint>
+
+#include "bench.hpp"
+
+using bench::clock_type;
+using taskio::task;
+
+namespace {
+
+struct state {
+    std::coroutine_handle<> driver;
+    std::coroutine_handle<> partner;
+};
+
+// suspend into `self` and resume `peer` right away
+struct transfer {
+    std::coroutine_handle<> &self;
+    std::coroutine_handle<> peer;
+
+    static constexpr bool await_ready() noexcept { return false; }
+
+    std::coroutine_handle<>
+    await_suspend(std::coroutine_handle<> current) noexcept {
+        self = current;
+        return peer;
+    }
+
+    constexpr void await_resume() const noexcept {}
+};
+
+// parked until the driver destroys it
+task<> partner(state &s) {
+    for (;;) {
+        co_await transfer{s.partner, s.driver};
+    }
+}
+
+task<> drive(uint64_t ops, clock_type::duration &out) {
+    state s;
+    task<> other = partner(s);
+    s.partner = other.get_handle();
+
+    const auto start = clock_type::now();
+    for (uint64_t i = 0; i < ops / 2; ++i) {
+        co_await transfer{s.driver, s.partner};
+    }
+    out = clock_type::now() - start;
+}
+
+clock_type::duration direct(uint64_t ops) {
+    clock_type::duration elapsed{};
+    bench::run_on_context(drive(ops, elapsed));
+    return elapsed;
+}
+
+struct span {
+    clock_type::time_point start;
+    clock_type::time_point end;
+};
+
+task<> yield_loop(uint64_t ops, span &out) {
+    out.start = clock_type::now();
+    for (uint64_t i = 0; i < ops / 2; ++i) {
+        co_await bench::yield{};
+    }
+    out.end = clock_type::now();
+}
+
+// two tasks take turns through the ready queue
+clock_type::duration through_loop(uint64_t ops) {
+    span spans[2];
+    taskio::io_context ctx;
+    ctx.spawn(yield_loop(ops, spans[0]));
+    ctx.spawn(yield_loop(ops, spans[1]));
+    ctx.start();
+    ctx.join();
+    return std::max(spans[0].end, spans[1].end) -
+           std::min(spans[0].start, spans[1].start);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    bench::suite suite("symmetric_transfer", argc, argv);
+    suite.run("switch/symmetric_transfer", 2000000, direct);
+    suite.run("switch/ready_queue", 2000000, through_loop);
+    return suite.finish();
+}
@@ -0,0 +1,171 @@
+/**
+ * cancellation_source and cancellation_token: the token observing its
+ * source, pending file and socket requests completing with -ECANCELED, a
+ * task cancelled before it awaits not submitting anything, and polling the
+ * token of the current task.
+ */
+#include <cerrno>
+#include <chrono>
+#include <string_view>
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <taskio/cancellation.hpp>
+#include <taskio/io/file.hpp>
+#include <taskio/io/socket.hpp>
+#include <taskio/io_context.hpp>
+#include <taskio/task.hpp>
+#include <taskio/timer.hpp>
+
+#include "check.hpp"
+
+using namespace std::chrono_literals;
+
+using taskio::cancellation_source;
+using taskio::cancellation_token;
+using taskio::io_context;
+using taskio::task;
+using test::check;
+
+namespace io = taskio::io;
+
+namespace {
+
+constexpr std::string_view message = "data";
+
+template<typename Fn>
+void on_context(Fn &&fn) {
+    io_context ctx;
+    ctx.spawn(fn(ctx));
+    ctx.start();
+    ctx.join();
+}
+
+void source_and_token() {
+    cancellation_token none;
+    check(!none.can_be_cancelled());
+    check(!none.is_cancellation_requested());
+
+    cancellation_source source;
+    cancellation_token token = source.token();
+    cancellation_token copy = token;
+    check(token.can_be_cancelled() && copy.can_be_cancelled());
+    check(!source.is_cancellation_requested());
+    check(!copy.is_cancellation_requested());
+
+    source.request_cancellation();
+    check(source.is_cancellation_requested());
+    check(token.is_cancellation_requested());
+    check(copy.is_cancellation_requested());
+    // a cancelled source stays cancelled
+    source.request_cancellation();
+    check(copy.is_cancellation_requested());
+}
+
+task<int> read_some(int fd) {
+    char buf[16];
+    co_return co_await io::read(fd, buf);
+}
+
+task<int> recv_some(int fd) {
+    char buf[16];
+    co_return co_await io::recv(fd, buf);
+}
+
+task<int> sleep_long() { co_return co_await taskio::sleep_for(10s); }
+
+task<> cancel_after(cancellation_source &source,
+                    std::chrono::milliseconds delay) {
+    co_await taskio::sleep_for(delay);
+    source.request_cancellation();
+}
+
+task<> pending_requests_cancelled(io_context &ctx) {
+    int pipe_fds[2];
+    check(::pipe(pipe_fds) == 0);
+    {
+        cancellation_source source;
+        ctx.spawn(cancel_after(source, 10ms));
+        const int result = co_await taskio::with_cancellation(
+            read_some(pipe_fds[0]), source.token()
+        );
+        check(result == -ECANCELED);
+    }
+    // the cancelled read is gone, it doesn't take the data written after
+    check(::write(pipe_fds[1], message.data(), message.size())
+          == int(message.size()));
+    check(co_await read_some(pipe_fds[0]) == int(message.size()));
+    ::close(pipe_fds[0]);
+    ::close(pipe_fds[1]);
+
+    int sock_fds[2];
+    check(::socketpair(AF_UNIX, SOCK_STREAM, 0, sock_fds) == 0);
+    {
+        cancellation_source source;
+        ctx.spawn(cancel_after(source, 10ms));
+        const int result = co_await taskio::with_cancellation(
+            recv_some(sock_fds[0]), source.token()
+        );
+        check(result == -ECANCELED);
+    }
+    ::close(sock_fds[0]);
+    ::close(sock_fds[1]);
+}
+
+task<> cancelled_before_awaiting(io_context &) {
+    int fds[2];
+    check(::pipe(fds) == 0);
+    check(::write(fds[1], message.data(), message.size())
+          == int(message.size()));
+
+    cancellation_source source;
+    source.request_cancellation();
+    // a submitted read would succeed at once, the data is there
+    const int read_result =
+        co_await taskio::with_cancellation(read_some(fds[0]), source.token());
+    check(read_result == -ECANCELED);
+    check(co_await read_some(fds[0]) == int(message.size()));
+
+    const auto start = std::chrono::steady_clock::now();
+    const int sleep_result =
+        co_await taskio::with_cancellation(sleep_long(), source.token());
+    check(sleep_result == -ECANCELED);
+    check(std::chrono::steady_clock::now() - start < 5s);
+    ::close(fds[0]);
+    ::close(fds[1]);
+}
+
+// a long computation polls the token of its task between its steps
+task<int> count_until_cancelled() {
+    cancellation_token token = co_await taskio::current_cancellation();
+    check(token.can_be_cancelled());
+    int rounds = 0;
+    while (!token.is_cancellation_requested()) {
+        co_await taskio::sleep_for(1ms);
+        ++rounds;
+    }
+    co_return rounds;
+}
+
+task<> polling_the_current_token(io_context &ctx) {
+    cancellation_token outside = co_await taskio::current_cancellation();
+    check(!outside.is_cancellation_requested());
+
+    cancellation_source source;
+    ctx.spawn(cancel_after(source, 10ms));
+    const int rounds = co_await taskio::with_cancellation(
+        count_until_cancelled(), source.token()
+    );
+    check(rounds > 0);
+    check(!outside.is_cancellation_requested());
+}
+
+} // namespace
+
+int main() {
+    source_and_token();
+    on_context(pending_requests_cancelled);
+    on_context(cancelled_before_awaiting);
+    on_context(polling_the_current_token);
+}
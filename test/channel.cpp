@@ -0,0 +1,186 @@
+/**
+ * Channels between tasks of different contexts, with small rings so that
+ * the cursors wrap around many times: values arrive once, in order for the
+ * spsc kind, one by one or in batches.
+ */
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+
+#include <taskio/channel.hpp>
+#include <taskio/io_context.hpp>
+#include <taskio/task.hpp>
+#include <taskio/task_group.hpp>
+
+#include "check.hpp"
+
+using taskio::io_context;
+using taskio::task;
+using test::check;
+
+namespace {
+
+// well past the wraparound of 16-bit cursors
+constexpr uint64_t value_num = 200000;
+constexpr std::size_t batch = 5;
+
+template<typename Fn>
+void on_two_contexts(Fn &&fn) {
+    io_context a;
+    io_context b;
+    b.hold();
+    a.spawn(fn(a, b));
+    a.start();
+    b.start();
+    a.join();
+    b.join();
+}
+
+using spsc = taskio::channel<uint64_t, 8>;
+
+task<> send_in_order(spsc &ch) {
+    for (uint64_t i = 0; i < value_num; ++i) {
+        co_await ch.send(i);
+    }
+}
+
+task<> recv_in_order(spsc &ch) {
+    for (uint64_t i = 0; i < value_num; ++i) {
+        check(co_await ch.recv() == i);
+    }
+}
+
+task<> send_batches(spsc &ch) {
+    uint64_t buf[batch];
+    for (uint64_t sent = 0; sent < value_num;) {
+        const auto num = std::min<uint64_t>(batch, value_num - sent);
+        for (uint64_t i = 0; i < num; ++i) {
+            buf[i] = sent + i;
+        }
+        // a batch may go in several parts
+        std::span<uint64_t> rest(buf, num);
+        while (!rest.empty()) {
+            rest = rest.subspan(co_await ch.send_n(rest));
+        }
+        sent += num;
+    }
+}
+
+task<> recv_batches(spsc &ch) {
+    uint64_t buf[batch + 2];
+    for (uint64_t received = 0; received < value_num;) {
+        const auto num = std::min<uint64_t>(std::size(buf),
+                                            value_num - received);
+        const auto got = co_await ch.recv_n(std::span(buf, num));
+        check(got > 0 && got <= num);
+        for (std::size_t i = 0; i < got; ++i) {
+            check(buf[i] == received + i);
+        }
+        received += got;
+    }
+}
+
+task<> spsc_across_contexts(io_context &a, io_context &b) {
+    auto ch = std::make_unique<spsc>();
+    {
+        taskio::task_group group;
+        group.spawn(a, send_in_order(*ch));
+        group.spawn(b, recv_in_order(*ch));
+        co_await group.join();
+    }
+    {
+        taskio::task_group group;
+        group.spawn(b, send_batches(*ch));
+        group.spawn(a, recv_batches(*ch));
+        co_await group.join();
+    }
+    b.release();
+}
+
+using strings = taskio::channel<std::string, 4>;
+
+constexpr uint64_t string_num = 20000;
+
+std::string make_string(uint64_t i) {
+    // longer than the small string buffer
+    return std::string(40, char('a' + i % 26)) + std::to_string(i);
+}
+
+task<> send_strings(strings &ch) {
+    for (uint64_t i = 0; i < string_num; ++i) {
+        co_await ch.send(make_string(i));
+    }
+}
+
+task<> recv_strings(strings &ch) {
+    for (uint64_t i = 0; i < string_num; ++i) {
+        check(co_await ch.recv() == make_string(i));
+    }
+}
+
+task<> strings_across_contexts(io_context &a, io_context &b) {
+    auto ch = std::make_unique<strings>();
+    taskio::task_group group;
+    group.spawn(a, send_strings(*ch));
+    group.spawn(b, recv_strings(*ch));
+    co_await group.join();
+    b.release();
+}
+
+using mpmc = taskio::channel<uint64_t, 8, taskio::channel_kind::mpmc>;
+
+constexpr uint64_t producer_num = 4;
+constexpr uint64_t consumer_num = 3;
+constexpr uint64_t per_producer = 30000;
+
+struct mpmc_state {
+    mpmc ch;
+    std::atomic<uint64_t> sum{0};
+    std::atomic<uint64_t> count{0};
+};
+
+task<> produce(mpmc_state &state, uint64_t first) {
+    for (uint64_t i = 0; i < per_producer; ++i) {
+        co_await state.ch.send(first + i);
+    }
+}
+
+task<> consume(mpmc_state &state, uint64_t num) {
+    uint64_t sum = 0;
+    for (uint64_t i = 0; i < num; ++i) {
+        sum += co_await state.ch.recv();
+    }
+    state.sum.fetch_add(sum, std::memory_order_relaxed);
+    state.count.fetch_add(num, std::memory_order_relaxed);
+}
+
+task<> mpmc_across_contexts(io_context &a, io_context &b) {
+    auto state = std::make_unique<mpmc_state>();
+    constexpr uint64_t total = producer_num * per_producer;
+    {
+        taskio::task_group group;
+        for (uint64_t i = 0; i < producer_num; ++i) {
+            group.spawn(i % 2 ? a : b, produce(*state, i * per_producer));
+        }
+        for (uint64_t i = 0; i < consumer_num; ++i) {
+            const uint64_t num = total / consumer_num
+                               + (i == 0 ? total % consumer_num : 0);
+            group.spawn(i % 2 ? b : a, consume(*state, num));
+        }
+        co_await group.join();
+    }
+    check(state->count.load() == total);
+    check(state->sum.load() == total * (total - 1) / 2);
+    b.release();
+}
+
+} // namespace
+
+int main() {
+    on_two_contexts(spsc_across_contexts);
+    on_two_contexts(strings_across_contexts);
+    on_two_contexts(mpmc_across_contexts);
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+#include <source_location>
+
+namespace test {
+
+/**
+ * @brief Abort with the location of the failed check, unlike assert() it
+ * also checks with NDEBUG
+ */
+inline void
+check(bool cond,
+      std::source_location where = std::source_location::current()) {
+    if (!cond) [[unlikely]] {
+        std::fprintf(stderr, "%s:%u: check failed in %s\n", where.file_name(),
+                     where.line(), where.function_name());
+        std::abort();
+    }
+}
+
+} // namespace test
@@ -0,0 +1,152 @@
+/**
+ * frame_pool: frames reused by the thread that freed them, frames freed by
+ * other threads batched back to their pool, the pool of an exited thread
+ * adopted by the next one, and frames too big for the pool.
+ */
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include <taskio/config.hpp>
+#include <taskio/detail/frame_pool.hpp>
+#include <taskio/detail/thread_info.hpp>
+
+#include "check.hpp"
+
+using taskio::detail::frame_pool;
+using taskio::detail::this_thread;
+using test::check;
+
+namespace {
+
+// more than a remote batch, less than a class keeps
+constexpr std::size_t frame_num = 200;
+constexpr int freeing_threads = 4;
+
+static_assert(frame_num > taskio::config::frame_remote_batch);
+static_assert(frame_num < taskio::config::frame_pool_cache_num);
+
+void *allocate(std::size_t size) {
+    void *frame = frame_pool::allocate(size);
+    check(reinterpret_cast<uintptr_t>(frame) % alignof(std::max_align_t)
+          == 0);
+    // the whole frame is usable
+    std::memset(frame, 0xab, size);
+    return frame;
+}
+
+std::vector<void *> sorted(std::vector<void *> frames) {
+    std::sort(frames.begin(), frames.end());
+    return frames;
+}
+
+void reused_by_the_same_thread() {
+    std::thread([] {
+        void *frame = allocate(100);
+        frame_pool::deallocate(frame);
+        check(allocate(100) == frame);
+        // another class
+        void *other = allocate(500);
+        check(other != frame);
+        frame_pool::deallocate(other);
+        frame_pool::deallocate(frame);
+    }).join();
+}
+
+void freed_by_other_threads() {
+    // each class is only used here, so the frames taken back are exactly
+    // the ones the other threads freed
+    constexpr std::size_t size = 300;
+    std::thread([] {
+        std::vector<void *> frames;
+        for (std::size_t i = 0; i < frame_num; ++i) {
+            frames.push_back(allocate(size));
+        }
+
+        std::vector<std::thread> threads;
+        for (int t = 0; t < freeing_threads; ++t) {
+            threads.emplace_back([&frames, t] {
+                for (std::size_t i = t; i < frame_num; i += freeing_threads) {
+                    frame_pool::deallocate(frames[i]);
+                }
+                // the last, partial batch
+                frame_pool::flush_remote();
+            });
+        }
+        for (auto &thread : threads) {
+            thread.join();
+        }
+
+        std::vector<void *> again;
+        for (std::size_t i = 0; i < frame_num; ++i) {
+            again.push_back(allocate(size));
+        }
+        check(sorted(again) == sorted(frames));
+        for (void *frame : again) {
+            frame_pool::deallocate(frame);
+        }
+    }).join();
+}
+
+void adopted_after_exit() {
+    constexpr std::size_t size = 700;
+    // this thread keeps a pool of its own, not the one parked below
+    frame_pool::deallocate(allocate(64));
+    void *cached = nullptr;
+    void *late = nullptr;
+    std::thread([&] {
+        cached = allocate(size);
+        late = allocate(size);
+        frame_pool::deallocate(cached);
+    }).join();
+
+    // the frame outlives its thread, its pool is still there
+    frame_pool::deallocate(late);
+    frame_pool::flush_remote();
+
+    std::thread([&] {
+        check(this_thread.frames == nullptr);
+        // the pool parked last is adopted, with its frames
+        check(allocate(size) == cached);
+        check(this_thread.frames != nullptr);
+        check(allocate(size) == late);
+        frame_pool::deallocate(late);
+        frame_pool::deallocate(cached);
+    }).join();
+}
+
+void too_big_for_the_pool() {
+    // the frame header takes 16 bytes
+    constexpr std::size_t largest = taskio::config::frame_pool_max_size - 16;
+    void *large = nullptr;
+    std::thread([&] {
+        void *pooled = allocate(largest);
+        frame_pool::deallocate(pooled);
+        check(allocate(largest) == pooled);
+        frame_pool::deallocate(pooled);
+    }).join();
+
+    std::thread([&] {
+        large = allocate(largest + 1);
+        // bypasses the pool
+        check(this_thread.frames == nullptr);
+    }).join();
+
+    // freed on another thread without a pool, it goes back to operator new
+    std::thread([&] {
+        frame_pool::deallocate(large);
+        check(this_thread.frames == nullptr);
+    }).join();
+}
+
+} // namespace
+
+int main() {
+    reused_by_the_same_thread();
+    freed_by_other_threads();
+    adopted_after_exit();
+    too_big_for_the_pool();
+}
@@ -0,0 +1,195 @@
+/**
+ * generator: elements_of nesting generators and plain ranges, yielded
+ * lvalues lent to the consumer and copied only when it takes them,
+ * exceptions thrown by a nested generator, and the ranges integration.
+ */
+#include <algorithm>
+#include <iterator>
+#include <numeric>
+#include <ranges>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <taskio/generator.hpp>
+
+#include "check.hpp"
+
+using taskio::elements_of;
+using taskio::generator;
+using test::check;
+
+namespace {
+
+generator<int> iota(int first, int last) {
+    for (int i = first; i < last; ++i) {
+        co_yield int(i);
+    }
+}
+
+generator<int> nothing() { co_return; }
+
+// yields [0, 2^depth) through `depth` levels of nesting
+generator<int> nested(int depth, int first = 0) {
+    if (depth == 0) {
+        co_yield int(first);
+        co_return;
+    }
+    const int half = 1 << (depth - 1);
+    co_yield elements_of(nested(depth - 1, first));
+    co_yield elements_of(nested(depth - 1, first + half));
+}
+
+template<typename Gen>
+std::vector<int> collect(Gen &&gen) {
+    std::vector<int> values;
+    for (int value : gen) {
+        values.push_back(value);
+    }
+    return values;
+}
+
+generator<int> mixed() {
+    co_yield 0;
+    co_yield elements_of(iota(1, 4));
+    co_yield elements_of(nothing());
+    const std::vector<int> range{4, 5};
+    co_yield elements_of(range);
+    auto lvalue = iota(6, 8);
+    co_yield elements_of(std::move(lvalue));
+    co_yield 8;
+}
+
+void elements_of_nesting() {
+    check(collect(mixed()) == std::vector<int>{0, 1, 2, 3, 4, 5, 6, 7, 8});
+    check(collect(nothing()).empty());
+
+    std::vector<int> expected(1 << 6);
+    std::iota(expected.begin(), expected.end(), 0);
+    check(collect(nested(6)) == expected);
+}
+
+// counts the copies it went through, moves keep the count
+struct counted {
+    explicit counted(std::string text) : text(std::move(text)) {}
+
+    counted(const counted &rhs) : text(rhs.text), copies(rhs.copies + 1) {}
+
+    counted(counted &&rhs) noexcept
+        : text(std::move(rhs.text)), copies(rhs.copies) {}
+
+    std::string text;
+    int copies = 0;
+};
+
+generator<counted> lend(bool &intact) {
+    counted value{"lent"};
+    co_yield value;
+    // the consumer moved from its own copy
+    intact = value.text == "lent" && value.copies == 0;
+    co_yield value;
+    co_yield counted{"rvalue"};
+}
+
+void lvalues_lent() {
+    bool intact = false;
+    auto gen = lend(intact);
+    auto it = gen.begin();
+    // read in place
+    check(it->text == "lent" && it->copies == 0);
+    counted taken = *it;
+    check(taken.text == "lent" && taken.copies == 1);
+    // the copy is made once, then moved out
+    counted again = *it;
+    check(again.copies == 1);
+
+    ++it;
+    check(intact);
+    check(it->copies == 0);
+    ++it;
+    counted moved = *it;
+    check(moved.text == "rvalue" && moved.copies == 0);
+    ++it;
+    check(it == std::default_sentinel);
+}
+
+generator<int> fail_after(int count) {
+    co_yield elements_of(iota(0, count));
+    throw std::runtime_error("nested");
+}
+
+generator<int> outer_catches(std::string &caught) {
+    try {
+        co_yield elements_of(fail_after(2));
+    } catch (const std::runtime_error &e) {
+        caught = e.what();
+    }
+    co_yield 100;
+}
+
+generator<int> outer_passes() {
+    co_yield -1;
+    co_yield elements_of(fail_after(1));
+    co_yield 100;
+}
+
+void nested_exceptions() {
+    std::string caught;
+    check(collect(outer_catches(caught)) == std::vector<int>{0, 1, 100});
+    check(caught == "nested");
+
+    std::vector<int> values;
+    std::string_view what;
+    try {
+        for (int value : outer_passes()) {
+            values.push_back(value);
+        }
+    } catch (const std::runtime_error &e) {
+        what = e.what();
+    }
+    check(what == "nested");
+    check(values == std::vector<int>{-1, 0});
+
+    // thrown before the first value, by begin()
+    what = {};
+    auto gen = fail_after(0);
+    try {
+        (void)gen.begin();
+    } catch (const std::runtime_error &e) {
+        what = e.what();
+    }
+    check(what == "nested");
+}
+
+static_assert(std::ranges::view<generator<int>>);
+static_assert(std::ranges::input_range<generator<int>>);
+static_assert(!std::ranges::forward_range<generator<int>>);
+static_assert(
+    std::same_as<std::ranges::range_reference_t<generator<int>>, int &&>
+);
+
+void ranges_integration() {
+    auto squares = nested(4)
+                 | std::views::filter([](int i) { return i % 2 == 1; })
+                 | std::views::transform([](int i) { return i * i; })
+                 | std::views::take(3);
+    check(collect(squares) == std::vector<int>{1, 9, 25});
+
+    std::vector<int> copied;
+    std::ranges::copy(iota(0, 4), std::back_inserter(copied));
+    check(copied == std::vector<int>{0, 1, 2, 3});
+
+    auto gen = nothing();
+    check(gen.begin() == gen.end());
+}
+
+} // namespace
+
+int main() {
+    elements_of_nesting();
+    lvalues_lent();
+    nested_exceptions();
+    ranges_integration();
+}
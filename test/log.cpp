@@ -0,0 +1,179 @@
+/**
+ * The async log backend: records of several threads written whole and in
+ * order per thread, a full ring dropping and counting records, an err
+ * record too big for the ring written directly after the ones before it,
+ * and flush_log() returning once the records are out. The backend is called
+ * directly, so this runs whatever config::async_log is.
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <format>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+#include <taskio/log/log.hpp>
+
+#include "check.hpp"
+
+using taskio::detail::err_to_ring;
+using taskio::detail::flush_log;
+using taskio::detail::log_ring;
+using taskio::detail::log_to_ring;
+using test::check;
+
+namespace {
+
+constexpr int thread_num = 4;
+constexpr int record_num = 1000;
+
+/**
+ * @brief Sends what is written to `fd` to a file until finish(), which
+ * restores `fd` and returns what was written
+ */
+class capture {
+  public:
+    explicit capture(std::FILE *file) : file(file), fd(::fileno(file)) {
+        std::fflush(file);
+        saved = ::dup(fd);
+        check(saved >= 0);
+        char path[] = "/tmp/taskio_log_XXXXXX";
+        int tmp = ::mkstemp(path);
+        check(tmp >= 0);
+        this->path = path;
+        check(::dup2(tmp, fd) == fd);
+        ::close(tmp);
+    }
+
+    std::string finish() {
+        std::fflush(file);
+        check(::dup2(saved, fd) == fd);
+        ::close(saved);
+        std::ifstream in(path);
+        std::string text{std::istreambuf_iterator<char>(in), {}};
+        std::remove(path.c_str());
+        return text;
+    }
+
+  private:
+    std::FILE *file;
+    int fd;
+    int saved;
+    std::string path;
+};
+
+std::vector<std::string> lines_of(const std::string &text) {
+    std::vector<std::string> lines;
+    std::istringstream in(text);
+    for (std::string line; std::getline(in, line);) {
+        lines.push_back(line);
+    }
+    return lines;
+}
+
+void records_of_several_threads() {
+    capture out(stdout);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < thread_num; ++t) {
+        threads.emplace_back([t] {
+            const std::string_view text = "text";
+            for (int i = 0; i < record_num; ++i) {
+                log_to_ring("thread {} record {} {}\n", t, i, text);
+            }
+            flush_log();
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    const auto lines = lines_of(out.finish());
+
+    check(lines.size() == thread_num * record_num);
+    int next[thread_num]{};
+    for (const auto &line : lines) {
+        int t = -1;
+        int i = -1;
+        char text[8]{};
+        check(std::sscanf(line.c_str(), "thread %d record %d %7s", &t, &i,
+                          text)
+              == 3);
+        check(t >= 0 && t < thread_num);
+        check(i == next[t]++);
+        check(std::string_view{text} == "text");
+    }
+}
+
+void full_ring_drops() {
+    constexpr int flood = 10000;
+    const std::string text(1000, 'x');
+    const std::string_view payload = text;
+    capture out(stdout);
+    capture err(stderr);
+    std::thread([&payload] {
+        // far faster than the writer drains
+        for (int i = 0; i < flood; ++i) {
+            log_to_ring("{} {}\n", i, payload);
+        }
+        flush_log();
+        // the drops are reported along with the next records
+        log_to_ring("last\n");
+        flush_log();
+    }).join();
+    const auto err_lines = lines_of(err.finish());
+    const auto out_lines = lines_of(out.finish());
+
+    int dropped = 0;
+    for (const auto &line : err_lines) {
+        int n = 0;
+        check(std::sscanf(line.c_str(), "taskio: %d log records dropped", &n)
+              == 1);
+        dropped += n;
+    }
+    check(dropped > 0);
+    check(out_lines.size() == std::size_t(flood - dropped + 1));
+    check(out_lines.back() == "last");
+}
+
+void oversized_err_written_directly() {
+    const std::string text(log_ring::capacity, 'y');
+    const std::string_view huge = text;
+    check(!log_ring::fits(huge.size()));
+    capture err(stderr);
+    std::thread([&huge] {
+        err_to_ring("before\n");
+        err_to_ring("{}\n", huge);
+        err_to_ring("after\n");
+        flush_log();
+    }).join();
+    const auto lines = lines_of(err.finish());
+
+    check(lines.size() == 3);
+    check(lines[0] == "before");
+    check(lines[1] == huge);
+    check(lines[2] == "after");
+}
+
+void flushed_records_are_written() {
+    for (int i = 0; i < 3; ++i) {
+        capture out(stdout);
+        log_to_ring("flushed {}\n", i);
+        // nothing but flush_log() waits for the writer
+        flush_log();
+        check(out.finish() == std::format("flushed {}\n", i));
+    }
+}
+
+} // namespace
+
+int main() {
+    records_of_several_threads();
+    full_ring_drops();
+    oversized_err_written_directly();
+    flushed_records_are_written();
+}
@@ -0,0 +1,277 @@
+/**
+ * The queues behind the scheduler: the MPSC injection queue and the
+ * work-stealing deque under contention, the ready queue across segments
+ * and the LIFO slot with its budget. Two contexts flooding each other's
+ * injection queue must not wait on each other, and a context that exited
+ * takes no more tasks.
+ */
+#include <atomic>
+#include <coroutine>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <taskio/context_options.hpp>
+#include <taskio/detail/co_deque.hpp>
+#include <taskio/detail/co_mpsc.hpp>
+#include <taskio/detail/ready_queue.hpp>
+#include <taskio/detail/worker_meta.hpp>
+#include <taskio/io_context.hpp>
+#include <taskio/task.hpp>
+
+#include "check.hpp"
+
+using taskio::io_context;
+using taskio::task;
+using test::check;
+
+namespace {
+
+// the queues only pass handles around, they never resume them
+std::coroutine_handle<> fake_handle(uint64_t i) {
+    return std::coroutine_handle<>::from_address(
+        reinterpret_cast<void *>((i + 1) * 16)
+    );
+}
+
+uint64_t fake_index(std::coroutine_handle<> handle) {
+    return reinterpret_cast<uint64_t>(handle.address()) / 16 - 1;
+}
+
+struct item {
+    uint32_t producer;
+    uint32_t seq;
+};
+
+void mpsc_full_and_empty() {
+    auto queue = std::make_unique<taskio::detail::mpsc<item, uint32_t, 8>>();
+    check(queue->empty());
+    for (uint32_t i = 0; i < 8; ++i) {
+        check(queue->try_post({0, i}));
+    }
+    check(!queue->try_post({0, 8}));
+    item value;
+    check(queue->try_fetch(value) && value.seq == 0);
+    check(queue->try_post({0, 8}));
+    for (uint32_t i = 1; i <= 8; ++i) {
+        check(queue->try_fetch(value) && value.seq == i);
+    }
+    check(queue->empty());
+    check(!queue->try_fetch(value));
+}
+
+void mpsc_many_producers() {
+    constexpr uint32_t producer_num = 4;
+    constexpr uint32_t per_producer = 100000;
+    auto queue = std::make_unique<taskio::detail::mpsc<item, uint32_t, 64>>();
+
+    std::vector<std::jthread> producers;
+    for (uint32_t p = 0; p < producer_num; ++p) {
+        producers.emplace_back([&queue, p] {
+            for (uint32_t i = 0; i < per_producer; ++i) {
+                while (!queue->try_post({p, i})) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    // each producer's items arrive in the order it posted them
+    uint32_t next[producer_num] = {};
+    for (uint32_t got = 0; got < producer_num * per_producer;) {
+        item value;
+        if (!queue->try_fetch(value)) {
+            std::this_thread::yield();
+            continue;
+        }
+        check(value.producer < producer_num);
+        check(value.seq == next[value.producer]++);
+        ++got;
+    }
+    check(queue->empty());
+}
+
+void deque_owner_and_thieves() {
+    constexpr uint64_t item_num = 200000;
+    constexpr int thief_num = 3;
+    auto deque = std::make_unique<taskio::detail::steal_deque<256>>();
+    auto taken = std::make_unique<std::atomic<uint8_t>[]>(item_num);
+    std::atomic<uint64_t> taken_num{0};
+
+    auto take = [&](std::coroutine_handle<> handle) {
+        const uint64_t i = fake_index(handle);
+        check(i < item_num);
+        check(taken[i].fetch_add(1, std::memory_order_relaxed) == 0);
+        taken_num.fetch_add(1, std::memory_order_relaxed);
+    };
+
+    std::vector<std::jthread> thieves;
+    for (int t = 0; t < thief_num; ++t) {
+        thieves.emplace_back([&] {
+            while (taken_num.load(std::memory_order_relaxed) < item_num) {
+                if (auto handle = deque->steal()) {
+                    take(handle);
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    // the owner pushes in bursts and pops about half of each back
+    for (uint64_t pushed = 0; pushed < item_num;) {
+        for (int i = 0; i < 100 && pushed < item_num; ++i) {
+            if (!deque->push(fake_handle(pushed))) {
+                break;
+            }
+            ++pushed;
+        }
+        for (int i = 0; i < 50; ++i) {
+            if (auto handle = deque->pop()) {
+                take(handle);
+            }
+        }
+    }
+    while (auto handle = deque->pop()) {
+        take(handle);
+    }
+    thieves.clear();
+    check(taken_num.load() == item_num);
+    check(deque->size() == 0);
+}
+
+void deque_bounds() {
+    taskio::detail::steal_deque<4> deque;
+    for (uint64_t i = 0; i < 4; ++i) {
+        check(deque.push(fake_handle(i)));
+    }
+    check(!deque.push(fake_handle(4)));
+    // the owner takes the newest, thieves the oldest
+    check(fake_index(deque.pop()) == 3);
+    check(fake_index(deque.steal()) == 0);
+    check(deque.push(fake_handle(5)));
+    check(fake_index(deque.steal()) == 1);
+    check(fake_index(deque.pop()) == 5);
+    check(fake_index(deque.pop()) == 2);
+    check(!deque.pop() && !deque.steal());
+}
+
+void ready_queue_across_segments() {
+    taskio::detail::ready_queue<4> queue;
+    uint64_t posted = 0;
+    uint64_t fetched = 0;
+    // the queue grows over several segments, then drains and grows again
+    for (int round = 0; round < 50; ++round) {
+        for (int i = 0; i < round % 13 + 1; ++i) {
+            queue.post_task(fake_handle(posted++));
+        }
+        for (int i = 0; i < round % 7 && queue.task_num() != 0; ++i) {
+            check(fake_index(queue.fetch_task()) == fetched++);
+        }
+        check(queue.task_num() == posted - fetched);
+    }
+    while (queue.task_num() != 0) {
+        check(fake_index(queue.fetch_task()) == fetched++);
+    }
+    check(fetched == posted);
+}
+
+void lifo_slot() {
+    auto work = std::make_unique<taskio::detail::worker_meta>();
+    work->init(taskio::context_options{});
+
+    // the slot runs first, a displaced task queues behind the others
+    work->post_task(fake_handle(0));
+    work->post_task(fake_handle(1));
+    work->post_next(fake_handle(2));
+    work->post_next(fake_handle(3));
+    check(work->task_num() == 4);
+    check(fake_index(work->schedule()) == 3);
+    check(fake_index(work->schedule()) == 0);
+    check(fake_index(work->schedule()) == 1);
+    check(fake_index(work->schedule()) == 2);
+    check(work->task_num() == 0);
+
+    // out of budget, the queue gets a turn before the slot
+    work->post_task(fake_handle(10));
+    for (uint32_t i = 0; i < taskio::config::lifo_slot_budget; ++i) {
+        work->post_next(fake_handle(20 + i));
+        check(fake_index(work->schedule()) == 20 + i);
+    }
+    work->post_next(fake_handle(30));
+    check(fake_index(work->schedule()) == 10);
+    check(fake_index(work->schedule()) == 30);
+    check(work->task_num() == 0);
+
+    work->deinit();
+}
+
+task<> count_run(std::atomic<uint64_t> &ran) {
+    ran.fetch_add(1, std::memory_order_relaxed);
+    co_return;
+}
+
+// spawns without yielding, the target can't drain meanwhile
+task<> flood(io_context &target, std::atomic<uint64_t> &ran, uint64_t num) {
+    for (uint64_t i = 0; i < num; ++i) {
+        target.spawn(count_run(ran));
+    }
+    co_return;
+}
+
+void injection_overflow() {
+    constexpr uint64_t per_context = 3 * taskio::config::mpsc_capacity;
+    std::atomic<uint64_t> ran{0};
+    io_context a;
+    io_context b;
+    a.spawn(flood(b, ran, per_context));
+    b.spawn(flood(a, ran, per_context));
+    a.start();
+    b.start();
+    a.join();
+    b.join();
+    check(ran.load() == 2 * per_context);
+}
+
+struct destroyed_flag {
+    explicit destroyed_flag(bool &flag) noexcept : flag(&flag) {}
+    destroyed_flag(destroyed_flag &&other) noexcept
+        : flag(std::exchange(other.flag, nullptr)) {}
+    ~destroyed_flag() {
+        if (flag != nullptr) {
+            *flag = true;
+        }
+    }
+
+    bool *flag;
+};
+
+task<> never_run(destroyed_flag, bool &ran) {
+    ran = true;
+    co_return;
+}
+
+void spawn_after_exit() {
+    bool destroyed = false;
+    bool ran = false;
+    io_context ctx;
+    ctx.start();
+    ctx.join();
+    ctx.spawn(never_run(destroyed_flag{destroyed}, ran));
+    check(destroyed && !ran);
+}
+
+} // namespace
+
+int main() {
+    mpsc_full_and_empty();
+    mpsc_many_producers();
+    deque_bounds();
+    deque_owner_and_thieves();
+    ready_queue_across_segments();
+    lifo_slot();
+    injection_overflow();
+    spawn_after_exit();
+}
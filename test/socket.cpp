@@ -0,0 +1,184 @@
+/**
+ * Socket operations over loopback: a plain echo, multishot accept and recv
+ * serving several clients, and a pending recv cancelled from another
+ * context.
+ */
+#include <cerrno>
+#include <chrono>
+#include <string_view>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <taskio/cancellation.hpp>
+#include <taskio/io/file.hpp>
+#include <taskio/io/socket.hpp>
+#include <taskio/io_context.hpp>
+#include <taskio/task.hpp>
+#include <taskio/timer.hpp>
+
+#include "check.hpp"
+
+using namespace std::chrono_literals;
+
+using taskio::io_context;
+using taskio::task;
+using test::check;
+
+namespace io = taskio::io;
+
+namespace {
+
+constexpr std::string_view message = "ping";
+constexpr int rounds = 8;
+constexpr int client_num = 4;
+
+int listen_loopback(sockaddr_in &addr) {
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    check(fd >= 0);
+    addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t len = sizeof(addr);
+    check(::bind(fd, reinterpret_cast<sockaddr *>(&addr), len) == 0);
+    check(::listen(fd, SOMAXCONN) == 0);
+    check(::getsockname(fd, reinterpret_cast<sockaddr *>(&addr), &len) == 0);
+    return fd;
+}
+
+task<> echo_once(int listen_fd) {
+    int fd = co_await io::accept(listen_fd);
+    check(fd >= 0);
+    char buf[64];
+    while (true) {
+        int n = co_await io::recv(fd, buf);
+        check(n >= 0);
+        if (n == 0) {
+            break;
+        }
+        check(co_await io::send(fd, std::string_view{buf, buf + n}) == n);
+    }
+    co_await io::close(fd);
+}
+
+task<> ping(sockaddr_in addr, int &answered) {
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    check(co_await io::connect(
+              fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)
+          )
+          == 0);
+    for (int i = 0; i < rounds; ++i) {
+        check(co_await io::send(fd, message) == int(message.size()));
+        char buf[64];
+        int got = 0;
+        // a stream may split the answer
+        while (got < int(message.size())) {
+            int n = co_await io::recv(fd, std::span(buf + got, buf + 64));
+            check(n > 0);
+            got += n;
+        }
+        check(std::string_view{buf, buf + got} == message);
+        ++answered;
+    }
+    co_await io::close(fd);
+}
+
+void echo_over_loopback() {
+    sockaddr_in addr;
+    int listen_fd = listen_loopback(addr);
+    int answered = 0;
+    io_context ctx;
+    ctx.spawn(echo_once(listen_fd));
+    ctx.spawn(ping(addr, answered));
+    ctx.start();
+    ctx.join();
+    ::close(listen_fd);
+    check(answered == rounds);
+}
+
+task<> echo_multishot(int fd, int &served) {
+    {
+        auto stream = io::recv_multishot(fd);
+        while (true) {
+            io::recv_result r = co_await stream.next();
+            if (r.result <= 0) {
+                check(r.result == 0);
+                break;
+            }
+            check(co_await io::send(fd, r.buf.data()) == r.result);
+        }
+    }
+    co_await io::close(fd);
+    ++served;
+}
+
+task<> accept_all(io_context &ctx, int listen_fd, int &served) {
+    auto acceptor = io::accept_multishot(listen_fd);
+    for (int i = 0; i < client_num; ++i) {
+        int fd = co_await acceptor.next();
+        check(fd >= 0);
+        ctx.spawn(echo_multishot(fd, served));
+    }
+}
+
+void accept_and_recv_multishot() {
+    sockaddr_in addr;
+    int listen_fd = listen_loopback(addr);
+    int served = 0;
+    int answered = 0;
+    io_context ctx;
+    ctx.spawn(accept_all(ctx, listen_fd, served));
+    for (int i = 0; i < client_num; ++i) {
+        ctx.spawn(ping(addr, answered));
+    }
+    ctx.start();
+    ctx.join();
+    ::close(listen_fd);
+    check(served == client_num);
+    check(answered == client_num * rounds);
+}
+
+task<int> recv_nothing(int fd) {
+    char buf[16];
+    co_return co_await io::recv(fd, buf);
+}
+
+task<> wait_for_data(io_context &other, int fd,
+                     taskio::cancellation_token token, int &result) {
+    result = co_await taskio::with_cancellation(recv_nothing(fd), token);
+    other.release();
+}
+
+task<> cancel_later(taskio::cancellation_source &source) {
+    co_await taskio::sleep_for(20ms);
+    source.request_cancellation();
+}
+
+void cancel_from_another_context() {
+    int fds[2];
+    check(::socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+    taskio::cancellation_source source;
+    int result = 0;
+    io_context owner;
+    io_context canceller;
+    canceller.hold();
+    owner.spawn(wait_for_data(canceller, fds[0], source.token(), result));
+    canceller.spawn(cancel_later(source));
+    owner.start();
+    canceller.start();
+    owner.join();
+    canceller.join();
+    ::close(fds[0]);
+    ::close(fds[1]);
+    check(result == -ECANCELED);
+}
+
+} // namespace
+
+int main() {
+    echo_over_loopback();
+    accept_and_recv_multishot();
+    cancel_from_another_context();
+}
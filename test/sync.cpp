@@ -0,0 +1,142 @@
+/**
+ * async_mutex and async_semaphore serve their waiters in FIFO order, each
+ * one resumed on its own context.
+ */
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <vector>
+
+#include <taskio/async_mutex.hpp>
+#include <taskio/async_semaphore.hpp>
+#include <taskio/io_context.hpp>
+#include <taskio/task.hpp>
+#include <taskio/task_group.hpp>
+#include <taskio/timer.hpp>
+
+#include "check.hpp"
+
+using namespace std::chrono_literals;
+
+using taskio::io_context;
+using taskio::task;
+using test::check;
+
+namespace {
+
+constexpr int waiter_num = 6;
+constexpr std::size_t context_num = 3;
+
+struct contexts {
+    io_context ctx[context_num];
+
+    template<typename Fn>
+    void run(Fn &&fn) {
+        for (std::size_t i = 1; i < context_num; ++i) {
+            ctx[i].hold();
+        }
+        ctx[0].spawn(fn(*this));
+        for (auto &c : ctx) {
+            c.start();
+        }
+        for (auto &c : ctx) {
+            c.join();
+        }
+    }
+
+    void release() {
+        for (std::size_t i = 1; i < context_num; ++i) {
+            ctx[i].release();
+        }
+    }
+
+    io_context &operator[](int i) { return ctx[i % context_num]; }
+};
+
+io_context *current() { return taskio::detail::this_thread.ctx; }
+
+struct mutex_fifo {
+    taskio::async_mutex mutex;
+    std::atomic<int> arrived{0};
+    // written under the mutex
+    std::vector<int> order;
+};
+
+task<> lock_in_turn(mutex_fifo &state, int id) {
+    // a waiter may have been stolen before it waits, not while it waits
+    io_context *owner = current();
+    state.arrived.fetch_add(1, std::memory_order_release);
+    auto lock = co_await state.mutex.scoped_lock();
+    check(current() == owner);
+    state.order.push_back(id);
+}
+
+task<> check_mutex_fifo(contexts &ctxs) {
+    mutex_fifo state;
+    taskio::task_group group;
+    {
+        auto lock = co_await state.mutex.scoped_lock();
+        for (int i = 0; i < waiter_num; ++i) {
+            group.spawn(ctxs[i + 1], lock_in_turn(state, i));
+            while (state.arrived.load(std::memory_order_acquire) != i + 1) {
+                co_await taskio::sleep_for(1ms);
+            }
+            // the waiter queues right after arriving
+            co_await taskio::sleep_for(10ms);
+        }
+    }
+    co_await group.join();
+    check(state.order.size() == waiter_num);
+    for (int i = 0; i < waiter_num; ++i) {
+        check(state.order[i] == i);
+    }
+    ctxs.release();
+}
+
+struct semaphore_fifo {
+    taskio::async_semaphore sem{1};
+    std::vector<int> order;
+};
+
+task<> acquire_in_turn(semaphore_fifo &state, int id) {
+    io_context *owner = current();
+    co_await state.sem.acquire();
+    check(current() == owner);
+    // a single permit, nobody else is inside
+    state.order.push_back(id);
+    state.sem.release();
+}
+
+task<> check_semaphore_fifo(contexts &ctxs) {
+    semaphore_fifo state;
+    taskio::task_group group;
+    co_await state.sem.acquire();
+    for (int i = 0; i < waiter_num; ++i) {
+        group.spawn(ctxs[i + 1], acquire_in_turn(state, i));
+        // every waiter takes the count one further below zero
+        while (state.sem.available() != -(i + 1)) {
+            co_await taskio::sleep_for(1ms);
+        }
+    }
+    state.sem.release();
+    co_await group.join();
+    check(state.sem.available() == 1);
+    check(state.order.size() == waiter_num);
+    for (int i = 0; i < waiter_num; ++i) {
+        check(state.order[i] == i);
+    }
+    ctxs.release();
+}
+
+} // namespace
+
+int main() {
+    {
+        contexts ctxs;
+        ctxs.run(check_mutex_fifo);
+    }
+    {
+        contexts ctxs;
+        ctxs.run(check_semaphore_fifo);
+    }
+}
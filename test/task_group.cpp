@@ -0,0 +1,128 @@
+/**
+ * task_group: join() waits for every child wherever it runs, rethrows the
+ * first exception, and a failing child stops its siblings.
+ */
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <stdexcept>
+#include <string_view>
+
+#include <taskio/io_context.hpp>
+#include <taskio/task.hpp>
+#include <taskio/task_group.hpp>
+#include <taskio/timer.hpp>
+
+#include "check.hpp"
+
+using namespace std::chrono_literals;
+
+using taskio::io_context;
+using taskio::task;
+using test::check;
+
+namespace {
+
+using clock_type = std::chrono::steady_clock;
+
+constexpr int child_num = 16;
+
+template<typename Fn>
+void on_two_contexts(Fn &&fn) {
+    io_context a;
+    io_context b;
+    b.hold();
+    a.spawn(fn(a, b));
+    a.start();
+    b.start();
+    a.join();
+    b.join();
+}
+
+task<> finish_after(std::atomic<int> &done, std::chrono::milliseconds delay) {
+    co_await taskio::sleep_for(delay);
+    done.fetch_add(1, std::memory_order_relaxed);
+}
+
+task<> waits_for_every_child(io_context &, io_context &b) {
+    std::atomic<int> done{0};
+    // the owner may have been stolen before it got here
+    io_context *owner = taskio::detail::this_thread.ctx;
+    taskio::task_group group;
+    for (int i = 0; i < child_num; ++i) {
+        // the later children finish first
+        const auto delay = (child_num - i) * 1ms;
+        if (i % 2 == 0) {
+            group.spawn(finish_after(done, delay));
+        } else {
+            group.spawn(b, finish_after(done, delay));
+        }
+    }
+    co_await group.join();
+    check(done.load() == child_num);
+    check(group.size() == 0);
+    // the owner resumes where it created the group
+    check(taskio::detail::this_thread.ctx == owner);
+
+    // a joined group can be used again
+    group.spawn(b, finish_after(done, 1ms));
+    co_await group.join();
+    check(done.load() == child_num + 1);
+    b.release();
+}
+
+task<> fail_after(const char *what, std::chrono::milliseconds delay) {
+    co_await taskio::sleep_for(delay);
+    throw std::runtime_error(what);
+}
+
+// sleeps until the group is stopped
+task<> sleep_long(std::atomic<int> &cancelled) {
+    const int result = co_await taskio::sleep_for(10s);
+    if (result == -ECANCELED) {
+        cancelled.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+task<> first_failure_stops_the_rest(io_context &, io_context &b) {
+    std::atomic<int> cancelled{0};
+    std::string_view what;
+    const auto start = clock_type::now();
+    taskio::task_group group;
+    group.spawn(sleep_long(cancelled));
+    group.spawn(b, sleep_long(cancelled));
+    group.spawn(b, fail_after("first", 5ms));
+    // throws once the first failure already stopped the group
+    group.spawn(fail_after("second", 30ms));
+    try {
+        co_await group.join();
+    } catch (const std::runtime_error &e) {
+        what = e.what();
+    }
+    check(what == "first");
+    check(group.stop_requested());
+    check(cancelled.load() == 2);
+    check(clock_type::now() - start < 5s);
+    b.release();
+}
+
+task<> cancel_from_the_owner(io_context &, io_context &b) {
+    std::atomic<int> cancelled{0};
+    taskio::task_group group;
+    for (int i = 0; i < child_num; ++i) {
+        group.spawn(b, sleep_long(cancelled));
+    }
+    co_await taskio::sleep_for(5ms);
+    group.cancel();
+    co_await group.join();
+    check(cancelled.load() == child_num);
+    b.release();
+}
+
+} // namespace
+
+int main() {
+    on_two_contexts(waits_for_every_child);
+    on_two_contexts(first_failure_stops_the_rest);
+    on_two_contexts(cancel_from_the_owner);
+}
@@ -0,0 +1,156 @@
+/**
+ * The timer wheel fires every timer at its tick and never early, across
+ * levels and beyond the wheel, and a sleep stopped from another context is
+ * cancelled by the context it sleeps on.
+ */
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#include <taskio/cancellation.hpp>
+#include <taskio/detail/timer_wheel.hpp>
+#include <taskio/io_context.hpp>
+#include <taskio/task.hpp>
+#include <taskio/timer.hpp>
+
+#include "check.hpp"
+
+using namespace std::chrono_literals;
+
+using taskio::io_context;
+using taskio::task;
+using taskio::detail::timer_node;
+using taskio::detail::timer_wheel;
+using test::check;
+
+namespace {
+
+struct test_timer : timer_node {
+    test_timer() noexcept { this->on_expire = &test_timer::on_timer; }
+
+    static void on_timer(timer_node *node) noexcept {
+        auto *self = static_cast<test_timer *>(node);
+        self->fired->push_back(self);
+    }
+
+    std::vector<test_timer *> *fired = nullptr;
+};
+
+void wheel_levels() {
+    // every level, their edges and past the last one
+    const uint64_t deltas[] = {
+        1,           2,           63,          64,          65,
+        4095,        4096,        4097,        262143,      262144,
+        262145,      16777215,    16777216,    16777216 + 70000,
+    };
+    constexpr std::size_t timer_num = std::size(deltas);
+
+    timer_wheel wheel;
+    std::vector<test_timer *> fired;
+    test_timer timers[timer_num];
+    test_timer removed;
+    const uint64_t base = timer_wheel::now_tick() + 1000;
+    for (std::size_t i = 0; i < timer_num; ++i) {
+        timers[i].expire = base + deltas[i];
+        timers[i].fired = &fired;
+        wheel.add(&timers[i]);
+    }
+    removed.expire = base + 64;
+    removed.fired = &fired;
+    wheel.add(&removed);
+    wheel.remove(&removed);
+    check(wheel.size() == timer_num);
+
+    wheel.advance(base);
+    check(fired.empty());
+    for (std::size_t i = 0; i < timer_num; ++i) {
+        wheel.advance(base + deltas[i] - 1);
+        check(fired.size() == i);
+        check(wheel.next_tick() <= base + deltas[i]);
+        wheel.advance(base + deltas[i]);
+        check(fired.size() == i + 1 && fired.back() == &timers[i]);
+    }
+    check(wheel.empty());
+    check(wheel.next_tick() == UINT64_MAX);
+    check(!removed.linked);
+}
+
+void wheel_same_tick() {
+    timer_wheel wheel;
+    std::vector<test_timer *> fired;
+    test_timer timers[5];
+    const uint64_t base = timer_wheel::now_tick() + 1000;
+    for (auto &timer : timers) {
+        timer.expire = base + 300;
+        timer.fired = &fired;
+        wheel.add(&timer);
+    }
+    wheel.advance(base + 299);
+    check(fired.empty());
+    wheel.advance(base + 1000);
+    check(fired.size() == std::size(timers));
+    for (auto &timer : timers) {
+        check(std::ranges::count(fired, &timer) == 1);
+    }
+}
+
+void wheel_due_at_cascade() {
+    // the first tick of an upper slot, the timer is cascaded down and due
+    // at the same tick
+    timer_wheel wheel;
+    std::vector<test_timer *> fired;
+    test_timer timer;
+    timer.expire = ((timer_wheel::now_tick() + 1000) | 63) + 1;
+    timer.fired = &fired;
+    wheel.add(&timer);
+    wheel.advance(timer.expire - 1);
+    check(fired.empty());
+    wheel.advance(timer.expire);
+    check(fired.size() == 1);
+}
+
+task<> sleep_long(int &result) {
+    // the task may have been stolen before, not while it sleeps
+    io_context *owner = taskio::detail::this_thread.ctx;
+    result = co_await taskio::sleep_for(10s);
+    check(taskio::detail::this_thread.ctx == owner);
+}
+
+task<> sleep_until_stopped(io_context &other,
+                           taskio::cancellation_token token, int &result) {
+    co_await taskio::with_cancellation(sleep_long(result), token);
+    other.release();
+}
+
+task<> stop_later(taskio::cancellation_source &source) {
+    co_await taskio::sleep_for(20ms);
+    source.request_cancellation();
+}
+
+void sleep_stopped_from_another_context() {
+    taskio::cancellation_source source;
+    int result = 0;
+    io_context sleeper;
+    io_context stopper;
+    stopper.hold();
+    sleeper.spawn(sleep_until_stopped(stopper, source.token(), result));
+    stopper.spawn(stop_later(source));
+    const auto start = std::chrono::steady_clock::now();
+    sleeper.start();
+    stopper.start();
+    sleeper.join();
+    stopper.join();
+    check(result == -ECANCELED);
+    check(std::chrono::steady_clock::now() - start < 5s);
+}
+
+} // namespace
+
+int main() {
+    wheel_levels();
+    wheel_same_tick();
+    wheel_due_at_cascade();
+    sleep_stopped_from_another_context();
+}
@@ -0,0 +1,180 @@
+/**
+ * when_all and when_any: values in argument order whatever the finishing
+ * order, exceptions rethrown, the first task to finish stopping the
+ * others, and children finishing on another context.
+ */
+#include <cerrno>
+#include <chrono>
+#include <stdexcept>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include <taskio/io_context.hpp>
+#include <taskio/task.hpp>
+#include <taskio/timer.hpp>
+#include <taskio/when_all.hpp>
+#include <taskio/when_any.hpp>
+
+#include "check.hpp"
+
+using namespace std::chrono_literals;
+
+using taskio::io_context;
+using taskio::task;
+using test::check;
+
+namespace {
+
+using clock_type = std::chrono::steady_clock;
+
+void on_context(task<> &&body) {
+    io_context ctx;
+    ctx.spawn(std::move(body));
+    ctx.start();
+    ctx.join();
+}
+
+task<int> value_after(int value, std::chrono::milliseconds delay) {
+    co_await taskio::sleep_for(delay);
+    co_return value;
+}
+
+task<> nothing() { co_return; }
+
+task<int> fail_after(const char *what, std::chrono::milliseconds delay) {
+    co_await taskio::sleep_for(delay);
+    throw std::runtime_error(what);
+}
+
+// sleeps until stopped, `result` is what the sleep returned
+task<int> sleep_until_stopped(int &result) {
+    result = co_await taskio::sleep_for(10s);
+    co_return -1;
+}
+
+task<> all_in_argument_order() {
+    // the later tasks finish first
+    auto [a, b, c] = co_await taskio::when_all(
+        value_after(1, 30ms), value_after(2, 10ms), nothing()
+    );
+    check(a == 1 && b == 2);
+    static_assert(std::is_same_v<decltype(c), std::monostate>);
+
+    std::vector<task<int>> tasks;
+    for (int i = 0; i < 5; ++i) {
+        tasks.push_back(value_after(i, (5 - i) * 3ms));
+    }
+    auto values = co_await taskio::when_all(std::move(tasks));
+    check(values == std::vector<int>{0, 1, 2, 3, 4});
+
+    // nothing to wait for
+    auto none = co_await taskio::when_all(std::vector<task<int>>{});
+    check(none.empty());
+}
+
+task<> all_rethrows() {
+    std::string_view what;
+    try {
+        co_await taskio::when_all(value_after(1, 1ms), fail_after("x", 5ms));
+    } catch (const std::runtime_error &e) {
+        what = e.what();
+    }
+    check(what == "x");
+
+    // the first in argument order, not the first to throw
+    what = {};
+    try {
+        co_await taskio::when_all(
+            fail_after("first", 20ms), fail_after("second", 1ms)
+        );
+    } catch (const std::runtime_error &e) {
+        what = e.what();
+    }
+    check(what == "first");
+}
+
+task<> any_first_wins() {
+    int first = 0;
+    int last = 0;
+    const auto start = clock_type::now();
+    auto winner = co_await taskio::when_any(
+        sleep_until_stopped(first), value_after(7, 5ms),
+        sleep_until_stopped(last)
+    );
+    check(winner.index == 1 && winner.value == 7);
+    // the losers were stopped, and done before the awaiting task resumed
+    check(first == -ECANCELED && last == -ECANCELED);
+    check(clock_type::now() - start < 5s);
+
+    std::vector<task<int>> tasks;
+    tasks.push_back(value_after(1, 40ms));
+    tasks.push_back(value_after(2, 5ms));
+    tasks.push_back(value_after(3, 40ms));
+    auto second = co_await taskio::when_any(std::move(tasks));
+    check(second.index == 1 && second.value == 2);
+}
+
+task<> any_rethrows() {
+    int loser = 0;
+    std::string_view what;
+    try {
+        co_await taskio::when_any(
+            sleep_until_stopped(loser), fail_after("winner", 5ms)
+        );
+    } catch (const std::runtime_error &e) {
+        what = e.what();
+    }
+    check(what == "winner");
+    check(loser == -ECANCELED);
+}
+
+task<int> finish_on(io_context &ctx, int value) {
+    co_await taskio::switch_to(ctx);
+    co_await taskio::sleep_for(1ms);
+    co_return value;
+}
+
+task<int> stopped_on(io_context &ctx, int &result) {
+    co_await taskio::switch_to(ctx);
+    result = co_await taskio::sleep_for(10s);
+    check(taskio::detail::this_thread.ctx == &ctx);
+    co_return -1;
+}
+
+task<> children_on_another_context(io_context &home, io_context &other) {
+    auto [a, b] = co_await taskio::when_all(
+        finish_on(other, 1), finish_on(other, 2)
+    );
+    check(a == 1 && b == 2);
+    co_await taskio::switch_to(home);
+
+    // the stop crosses over to the context the loser sleeps on
+    int loser = 0;
+    auto winner = co_await taskio::when_any(
+        stopped_on(other, loser), finish_on(home, 3)
+    );
+    check(winner.index == 1 && winner.value == 3);
+    check(loser == -ECANCELED);
+    other.release();
+}
+
+} // namespace
+
+int main() {
+    on_context(all_in_argument_order());
+    on_context(all_rethrows());
+    on_context(any_first_wins());
+    on_context(any_rethrows());
+
+    io_context home;
+    io_context other;
+    other.hold();
+    home.spawn(children_on_another_context(home, other));
+    home.start();
+    other.start();
+    home.join();
+    other.join();
+}
@@ -0,0 +1,160 @@
+/**
+ * Convert a dump written by taskio::trace::dump() to the Chrome trace event
+ * format, for chrome://tracing or ui.perfetto.dev:
+ *
+ *     trace2json taskio.trace > taskio.json
+ *
+ * Every thread is a track. A resumed coroutine is a slice lasting until
+ * control is back to the loop, spawns and finished tasks are instants and
+ * the I/O requests are async slices from submission to completion.
+ */
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+#include <taskio/trace.hpp>
+
+namespace trace = taskio::trace;
+
+namespace {
+
+struct converter {
+    explicit converter(const trace::file_header &header) noexcept
+        : header(header) {}
+
+    double to_us(uint64_t time) const noexcept {
+        auto ticks =
+            static_cast<double>(static_cast<int64_t>(time - header.time_base));
+        return ticks / header.ticks_per_ns / 1000.0;
+    }
+
+    void emit(const char *fmt_head, const trace::event &event,
+              uint32_t tid) {
+        std::printf("%s\n    {", first ? "" : ",");
+        first = false;
+        std::printf(fmt_head, event.id);
+        std::printf(", \"pid\": 1, \"tid\": %" PRIu32 ", \"ts\": %.3f", tid,
+                    to_us(event.time));
+    }
+
+    void thread(uint32_t tid, const std::vector<trace::event> &events) {
+        uint16_t ctx_id = events.empty() ? UINT16_MAX : events.back().ctx_id;
+        std::printf("%s\n    {\"name\": \"thread_name\", \"ph\": \"M\", "
+                    "\"pid\": 1, \"tid\": %" PRIu32 ", \"args\": {\"name\": ",
+                    first ? "" : ",", tid);
+        first = false;
+        if (ctx_id != UINT16_MAX) {
+            std::printf("\"io_context %u\"}}", static_cast<unsigned>(ctx_id));
+        } else {
+            std::printf("\"thread %" PRIu32 "\"}}", tid);
+        }
+
+        // the ring may start in the middle of a slice
+        bool in_slice = false;
+        for (const trace::event &event : events) {
+            switch (event.type) {
+            case trace::event_type::spawn:
+                emit("\"name\": \"spawn 0x%" PRIx64 "\", \"ph\": \"i\", "
+                     "\"s\": \"t\"",
+                     event, tid);
+                std::printf("}");
+                break;
+            case trace::event_type::resume:
+                emit("\"name\": \"0x%" PRIx64 "\", \"ph\": \"B\"", event, tid);
+                std::printf("}");
+                in_slice = true;
+                break;
+            case trace::event_type::suspend:
+                if (!in_slice) {
+                    break;
+                }
+                emit("\"name\": \"0x%" PRIx64 "\", \"ph\": \"E\"", event, tid);
+                std::printf("}");
+                in_slice = false;
+                break;
+            case trace::event_type::final_suspend:
+                emit("\"name\": \"done 0x%" PRIx64 "\", \"ph\": \"i\", "
+                     "\"s\": \"t\"",
+                     event, tid);
+                std::printf("}");
+                break;
+            case trace::event_type::io_submit:
+                emit("\"name\": \"io\", \"cat\": \"io\", \"ph\": \"b\", "
+                     "\"id\": \"0x%" PRIx64 "\"",
+                     event, tid);
+                std::printf(", \"args\": {\"opcode\": %" PRIu32 "}}",
+                            event.arg);
+                pending[event.id] = true;
+                break;
+            case trace::event_type::io_complete: {
+                auto it = pending.find(event.id);
+                if (it != pending.end() && it->second) {
+                    emit("\"name\": \"io\", \"cat\": \"io\", \"ph\": \"e\", "
+                         "\"id\": \"0x%" PRIx64 "\"",
+                         event, tid);
+                    it->second = false;
+                } else {
+                    // the next cqes of a multishot request
+                    emit("\"name\": \"cqe 0x%" PRIx64 "\", \"ph\": \"i\", "
+                         "\"s\": \"t\"",
+                         event, tid);
+                }
+                std::printf(", \"args\": {\"res\": %" PRId32 "}}",
+                            static_cast<int32_t>(event.arg));
+                break;
+            }
+            }
+        }
+    }
+
+    const trace::file_header &header;
+    // the requests submitted and not completed yet
+    std::unordered_map<uint64_t, bool> pending;
+    bool first = true;
+};
+
+} // namespace
+
+int main(int argc, char **argv) {
+    if (argc != 2) {
+        std::fprintf(stderr, "usage: %s <dump>\n", argv[0]);
+        return 1;
+    }
+    std::FILE *file = std::fopen(argv[1], "rb");
+    if (file == nullptr) {
+        std::perror(argv[1]);
+        return 1;
+    }
+
+    trace::file_header header;
+    if (std::fread(&header, sizeof(header), 1, file) != 1
+        || std::memcmp(header.magic, trace::file_header::magic_value,
+                       sizeof(header.magic)) != 0
+        || header.version != trace::file_header::version_value) {
+        std::fprintf(stderr, "%s: not a taskio trace\n", argv[1]);
+        return 1;
+    }
+
+    converter out{header};
+    std::printf("{\"displayTimeUnit\": \"ns\", \"traceEvents\": [");
+    std::vector<trace::event> events;
+    for (uint32_t i = 0; i < header.thread_num; ++i) {
+        trace::thread_header thread;
+        if (std::fread(&thread, sizeof(thread), 1, file) != 1) {
+            std::fprintf(stderr, "%s: truncated\n", argv[1]);
+            return 1;
+        }
+        events.resize(thread.event_num);
+        if (std::fread(events.data(), sizeof(trace::event), events.size(),
+                       file) != events.size()) {
+            std::fprintf(stderr, "%s: truncated\n", argv[1]);
+            return 1;
+        }
+        out.thread(thread.tid, events);
+    }
+    std::printf("\n]}\n");
+    std::fclose(file);
+    return 0;
+}